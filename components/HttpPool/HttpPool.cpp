@@ -0,0 +1,381 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "HttpPool.hpp"
+#include <string.h>
+#include <strings.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+
+static const char* TAG = "HttpPool";
+
+HttpPool &HttpPool::instance()
+{
+    static HttpPool pool;
+    return pool;
+}
+
+HttpPool::HttpPool()
+{
+    memset(conns, 0, sizeof(conns));
+    memset(dns, 0, sizeof(dns));
+    memset(&pool_stats, 0, sizeof(pool_stats));
+    lock = xSemaphoreCreateMutex();
+}
+
+/* Cached getaddrinfo, IPv4 only like the rest of the network stack here */
+bool HttpPool::resolve(const char *host, char *ip, size_t ip_len, HttpTiming *t)
+{
+    struct in_addr addr;
+    if (inet_pton(AF_INET, host, &addr) == 1) {     // already an address
+        strlcpy(ip, host, ip_len);
+        t->dns_cached = true;
+        return true;
+    }
+
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto &e : dns) {
+        if (e.host[0] && strcmp(e.host, host) == 0 && e.expires_us > now) {
+            strlcpy(ip, e.ip, ip_len);
+            pool_stats.dns_hits++;
+            xSemaphoreGive(lock);
+            t->dns_cached = true;
+            return true;
+        }
+    }
+    xSemaphoreGive(lock);
+
+    struct addrinfo hints = {};
+    struct addrinfo *res = NULL;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    int err = getaddrinfo(host, NULL, &hints, &res);
+    t->dns_us = esp_timer_get_time() - now;
+    if (err != 0 || res == NULL) {
+        ESP_LOGE(TAG,"DNS lookup failed for %s (%d)", host, err);
+        if (res) freeaddrinfo(res);
+        return false;
+    }
+    inet_ntop(AF_INET, &((struct sockaddr_in *)res->ai_addr)->sin_addr, ip, ip_len);
+    freeaddrinfo(res);
+
+    // Store in the matching or the oldest slot
+    xSemaphoreTake(lock, portMAX_DELAY);
+    DnsEntry *slot = &dns[0];
+    for (auto &e : dns) {
+        if (strcmp(e.host, host) == 0) { slot = &e; break; }
+        if (e.expires_us < slot->expires_us) slot = &e;
+    }
+    strlcpy(slot->host, host, sizeof(slot->host));
+    strlcpy(slot->ip, ip, sizeof(slot->ip));
+    slot->expires_us = esp_timer_get_time() + (int64_t)CONFIG_TUX_HTTP_DNS_TTL * 1000000;
+    pool_stats.dns_misses++;
+    pool_stats.dns_us += t->dns_us;
+    xSemaphoreGive(lock);
+
+    t->dns_cached = false;
+    return true;
+}
+
+/* Handle for host:port - kept one if idle, else a free or least recently used slot */
+HttpPool::Conn *HttpPool::acquire(const char *host, int port, const char *ip)
+{
+    Conn *slot = NULL;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto &c : conns) {
+        if (!c.busy && c.client && c.port == port && strcmp(c.host, host) == 0) {
+            slot = &c;
+            break;
+        }
+    }
+    if (slot == NULL) {
+        for (auto &c : conns) {
+            if (c.busy) continue;
+            if (c.client == NULL) { slot = &c; break; }
+            if (slot == NULL || c.last_used_us < slot->last_used_us) slot = &c;
+        }
+        if (slot && slot->client) {
+            pool_stats.evictions++;
+            esp_http_client_cleanup(slot->client);
+            slot->client = NULL;
+        }
+    }
+    if (slot) slot->busy = true;
+    xSemaphoreGive(lock);
+
+    if (slot == NULL) return NULL;      // every handle in use
+
+    if (slot->client) {
+        bool idle_too_long = esp_timer_get_time() - slot->last_used_us > (int64_t)CONFIG_TUX_HTTP_IDLE_TIMEOUT * 1000000;
+        if (strcmp(slot->ip, ip) != 0) {            // address changed after TTL expiry
+            esp_http_client_cleanup(slot->client);
+            slot->client = NULL;
+        } else if (idle_too_long) {
+            close(slot);    // server has likely dropped it already
+        }
+    }
+
+    if (slot->client == NULL) {
+        esp_http_client_config_t config = {};
+        config.host = ip;
+        config.port = port;
+        config.path = "/";
+        config.event_handler = event_handler;
+        config.user_data = slot;
+
+        slot->client = esp_http_client_init(&config);
+        if (slot->client == NULL) {
+            release(slot);
+            return NULL;
+        }
+        slot->open = false;
+        strlcpy(slot->host, host, sizeof(slot->host));
+        strlcpy(slot->ip, ip, sizeof(slot->ip));
+        slot->port = port;
+    }
+    return slot;
+}
+
+void HttpPool::release(Conn *conn)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    conn->last_used_us = esp_timer_get_time();
+    conn->handler = NULL;
+    conn->user_data = NULL;
+    conn->timing = NULL;
+    conn->busy = false;
+    xSemaphoreGive(lock);
+}
+
+void HttpPool::close(Conn *conn)
+{
+    esp_http_client_close(conn->client);
+    conn->open = false;
+}
+
+esp_err_t HttpPool::perform(Conn *conn, const char *path, const HttpValidators *validators)
+{
+    conn->connected = false;
+    conn->got_header = false;
+    memset(&conn->seen, 0, sizeof(conn->seen));
+    conn->mark_us = esp_timer_get_time();
+
+    // Same address and port as before - the client keeps its socket
+    char url[256];
+    char host_hdr[HTTP_POOL_HOST_LEN + 8];
+    snprintf(url, sizeof(url), "http://%s:%d%s", conn->ip, conn->port, path);
+    if (conn->port == 80) {
+        strlcpy(host_hdr, conn->host, sizeof(host_hdr));
+    } else {
+        snprintf(host_hdr, sizeof(host_hdr), "%s:%d", conn->host, conn->port);
+    }
+
+    esp_http_client_set_url(conn->client, url);
+    esp_http_client_set_header(conn->client, "Host", host_hdr);   // connect to the cached address, ask for the name
+
+    // Handle is shared - conditional headers only for this request
+    bool if_none_match = validators && validators->etag[0];
+    bool if_modified_since = validators && validators->last_modified[0];
+    if (if_none_match) esp_http_client_set_header(conn->client, "If-None-Match", validators->etag);
+    if (if_modified_since) esp_http_client_set_header(conn->client, "If-Modified-Since", validators->last_modified);
+
+    esp_err_t err = esp_http_client_perform(conn->client);
+
+    if (if_none_match) esp_http_client_delete_header(conn->client, "If-None-Match");
+    if (if_modified_since) esp_http_client_delete_header(conn->client, "If-Modified-Since");
+    return err;
+}
+
+esp_err_t HttpPool::get(const char *host, int port, const char *path,
+                        http_event_handle_cb handler, void *user_data,
+                        HttpTiming *timing, HttpValidators *validators)
+{
+    HttpTiming local;
+    HttpTiming *t = timing ? timing : &local;
+    memset(t, 0, sizeof(HttpTiming));
+    t->status = -1;
+
+    int64_t start = esp_timer_get_time();
+
+    char ip[16];
+    Conn *conn = NULL;
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    if (resolve(host, ip, sizeof(ip), t)) {
+        conn = acquire(host, port, ip);
+        if (conn == NULL) {
+            ESP_LOGE(TAG,"No free handle for %s:%d", host, port);
+            err = ESP_ERR_NO_MEM;
+        }
+    }
+    if (conn == NULL) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        pool_stats.requests++;
+        pool_stats.failures++;
+        xSemaphoreGive(lock);
+        return err;
+    }
+
+    conn->handler = handler;
+    conn->user_data = user_data;
+    conn->timing = t;
+
+    bool was_open = conn->open;
+    bool retried = false;
+    err = perform(conn, path, validators);
+    if (err != ESP_OK && was_open && !conn->connected && !conn->got_header) {
+        // Kept-alive socket closed by the server in the meantime, once more on a fresh one
+        close(conn);
+        retried = true;
+        err = perform(conn, path, validators);
+    }
+
+    t->reused = !conn->connected;
+    t->status = (err == ESP_OK) ? esp_http_client_get_status_code(conn->client) : -1;
+    t->total_us = esp_timer_get_time() - start;
+
+    // New copy - remember its validators for the next conditional request
+    if (validators && t->status == 200) *validators = conn->seen;
+
+    if (err != ESP_OK) {
+        close(conn);    // don't keep a socket in an unknown state
+    }
+    release(conn);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    pool_stats.requests++;
+    if (retried) pool_stats.retries++;
+    if (err != ESP_OK) pool_stats.failures++;
+    if (err == ESP_OK) {
+        if (t->status == 304) pool_stats.not_modified++;
+        if (t->reused) pool_stats.reused++;
+        pool_stats.connect_us += t->connect_us;
+        pool_stats.ttfb_us += t->ttfb_us;
+        pool_stats.body_us += t->body_us;
+    }
+    xSemaphoreGive(lock);
+
+    ESP_LOGI(TAG,"GET %s:%d status %d, %" PRId64 " bytes - dns %" PRId64 "us%s / connect %" PRId64 "us%s / ttfb %" PRId64 "us / body %" PRId64 "us / total %" PRId64 "us",
+                host, port, t->status, t->bytes,
+                t->dns_us, t->dns_cached ? " (cached)" : "",
+                t->connect_us, t->reused ? " (reused)" : "",
+                t->ttfb_us, t->body_us, t->total_us);
+    return err;
+}
+
+/* Records phase timestamps and forwards the event with the caller's user_data */
+esp_err_t HttpPool::event_handler(esp_http_client_event_t *evt)
+{
+    Conn *conn = (Conn *)evt->user_data;
+    if (conn == NULL) return ESP_OK;
+    if (evt->event_id == HTTP_EVENT_DISCONNECTED) conn->open = false;
+    if (conn->timing == NULL) return ESP_OK;     // close/cleanup outside a request
+
+    HttpTiming *t = conn->timing;
+    int64_t now = esp_timer_get_time();
+
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            conn->connected = true;
+            conn->open = true;
+            t->connect_us = now - conn->mark_us;
+            conn->mark_us = now;
+            break;
+        case HTTP_EVENT_HEADER_SENT:
+            conn->mark_us = now;
+            break;
+        case HTTP_EVENT_ON_HEADER:
+            if (!conn->got_header) {
+                conn->got_header = true;
+                t->ttfb_us = now - conn->mark_us;
+                conn->mark_us = now;
+            }
+            if (strcasecmp(evt->header_key, "ETag") == 0) {
+                strlcpy(conn->seen.etag, evt->header_value, sizeof(conn->seen.etag));
+            } else if (strcasecmp(evt->header_key, "Last-Modified") == 0) {
+                strlcpy(conn->seen.last_modified, evt->header_value, sizeof(conn->seen.last_modified));
+            }
+            break;
+        case HTTP_EVENT_ON_DATA:
+            if (!conn->got_header) {        // no headers reported, first data is the first byte
+                conn->got_header = true;
+                t->ttfb_us = now - conn->mark_us;
+                conn->mark_us = now;
+            }
+            t->bytes += evt->data_len;
+            break;
+        case HTTP_EVENT_ON_FINISH:
+            t->body_us = now - conn->mark_us;
+            break;
+        default:
+            break;
+    }
+
+    if (conn->handler == NULL) return ESP_OK;
+
+    evt->user_data = conn->user_data;
+    esp_err_t ret = conn->handler(evt);
+    evt->user_data = conn;
+    return ret;
+}
+
+void HttpPool::close_all()
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto &c : conns) {
+        if (!c.busy && c.client) {
+            esp_http_client_cleanup(c.client);
+            c.client = NULL;
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+void HttpPool::flush_dns()
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    memset(dns, 0, sizeof(dns));
+    xSemaphoreGive(lock);
+}
+
+void HttpPool::report()
+{
+    const HttpPoolStats &s = pool_stats;
+    uint32_t ok = s.requests - s.failures;
+    uint32_t fresh = ok - s.reused;
+
+    ESP_LOGI(TAG,"requests %" PRIu32 " (failed %" PRIu32 ", not modified %" PRIu32 ") / reused %" PRIu32 " / retries %" PRIu32 " / evictions %" PRIu32,
+                s.requests, s.failures, s.not_modified, s.reused, s.retries, s.evictions);
+    ESP_LOGI(TAG,"dns hits %" PRIu32 " / misses %" PRIu32 " avg %" PRId64 "us",
+                s.dns_hits, s.dns_misses, s.dns_misses ? s.dns_us / s.dns_misses : 0);
+    ESP_LOGI(TAG,"avg connect %" PRId64 "us (new sockets) / ttfb %" PRId64 "us / body %" PRId64 "us",
+                fresh ? s.connect_us / fresh : 0,
+                ok ? s.ttfb_us / ok : 0,
+                ok ? s.body_us / ok : 0);
+}
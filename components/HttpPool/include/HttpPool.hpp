@@ -0,0 +1,152 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Shared HTTP client pool for REST providers (weather now, more later).
+
+    - One esp_http_client handle per host:port is kept between requests, so
+      a kept-alive socket is reused instead of a new TCP handshake.
+    - Host names are resolved once and cached for CONFIG_TUX_HTTP_DNS_TTL
+      seconds; the client connects to the cached address with the original
+      Host header.
+    - Sockets idle longer than CONFIG_TUX_HTTP_IDLE_TIMEOUT are closed before
+      use, a request failing on a reused socket is retried once on a fresh one.
+    - Every request reports where the time went: DNS, connect, TTFB, body.
+    - Optional validators make it a conditional GET (If-None-Match /
+      If-Modified-Since); a 304 means the caller's copy is still current.
+
+    Handlers get the usual esp_http_client events with their own user_data.
+*/
+
+#ifndef TUX_HTTP_POOL_H_
+#define TUX_HTTP_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define HTTP_POOL_HOST_LEN  64
+#define HTTP_POOL_DNS_SLOTS 4
+
+// Latency breakdown of one request
+struct HttpTiming {
+    int64_t dns_us;         // 0 when the address came from the cache
+    int64_t connect_us;     // 0 when a kept-alive socket was reused
+    int64_t ttfb_us;        // request sent until the first response header
+    int64_t body_us;        // first header until the response is complete
+    int64_t total_us;
+    int64_t bytes;          // body bytes received
+    int status;             // HTTP status, -1 if no response
+    bool dns_cached;
+    bool reused;
+};
+
+// ETag / Last-Modified of the copy the caller has, updated from every 200
+struct HttpValidators {
+    char etag[64];
+    char last_modified[32];
+};
+
+struct HttpPoolStats {
+    uint32_t requests;
+    uint32_t failures;
+    uint32_t reused;        // requests served on a kept-alive socket
+    uint32_t retries;       // reused socket turned out closed by the server
+    uint32_t dns_hits;
+    uint32_t dns_misses;
+    uint32_t evictions;     // handles closed to make room for another host
+    uint32_t not_modified;  // 304 answers to conditional requests
+    int64_t dns_us;         // totals, averages in report()
+    int64_t connect_us;
+    int64_t ttfb_us;
+    int64_t body_us;
+};
+
+class HttpPool
+{
+    public:
+        /* Pool shared by all providers */
+        static HttpPool &instance();
+
+        /* GET http://host:port/path, body is delivered to handler as HTTP_EVENT_ON_DATA.
+           With validators it is conditional - status 304 and no body if unchanged */
+        esp_err_t get(const char *host, int port, const char *path,
+                      http_event_handle_cb handler, void *user_data,
+                      HttpTiming *timing = NULL, HttpValidators *validators = NULL);
+
+        /* Drop the kept-alive handles, e.g. when wifi goes down */
+        void close_all();
+
+        /* Forget cached addresses, e.g. after a network change */
+        void flush_dns();
+
+        const HttpPoolStats &stats() const { return pool_stats; }
+        void report();
+
+    private:
+        struct DnsEntry {
+            char host[HTTP_POOL_HOST_LEN];
+            char ip[16];
+            int64_t expires_us;
+        };
+
+        struct Conn {
+            char host[HTTP_POOL_HOST_LEN];
+            char ip[16];            // address the handle was created for
+            int port;
+            esp_http_client_handle_t client;
+            int64_t last_used_us;
+            bool busy;
+            bool open;              // socket connected, cleared on disconnect
+
+            // Per request, valid while busy
+            http_event_handle_cb handler;
+            void *user_data;
+            HttpTiming *timing;
+            HttpValidators seen;    // from the response headers
+            int64_t mark_us;
+            bool connected;
+            bool got_header;
+        };
+
+        HttpPool();
+
+        bool resolve(const char *host, char *ip, size_t ip_len, HttpTiming *t);
+        Conn *acquire(const char *host, int port, const char *ip);
+        void release(Conn *conn);
+        esp_err_t perform(Conn *conn, const char *path, const HttpValidators *validators);
+        void close(Conn *conn);
+
+        static esp_err_t event_handler(esp_http_client_event_t *evt);
+
+        SemaphoreHandle_t lock;
+        Conn conns[CONFIG_TUX_HTTP_POOL_SIZE];
+        DnsEntry dns[HTTP_POOL_DNS_SLOTS];
+        HttpPoolStats pool_stats;
+};
+
+#endif
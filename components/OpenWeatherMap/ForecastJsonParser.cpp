@@ -0,0 +1,88 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "ForecastJsonParser.hpp"
+
+#define ITEM_LEVEL  2       // list.N.<field>
+
+static int16_t tenths(const char *value)
+{
+    return (int16_t)lroundf(strtof(value, NULL) * 10.0f);
+}
+
+void ForecastJsonParser::reset()
+{
+    reset_tokenizer();
+    memset(&point, 0, sizeof(point));
+    has_dt = false;
+    points = 0;
+    id = 0;
+    tz = 0;
+}
+
+bool ForecastJsonParser::in_list_item() const
+{
+    return depth() > ITEM_LEVEL && index_at(1) >= 0 && strcmp(key_at(0), "list") == 0;
+}
+
+void ForecastJsonParser::on_value(const char *value, bool)
+{
+    if (path_is("city.id")) { id = (int32_t)strtol(value, NULL, 10); return; }
+    if (path_is("city.timezone")) { tz = (int32_t)strtol(value, NULL, 10); return; }
+    if (!in_list_item()) return;
+
+    if (path_is("dt", ITEM_LEVEL)) {
+        point.dt = (uint32_t)strtoul(value, NULL, 10);
+        has_dt = true;
+    } else if (path_is("main.temp", ITEM_LEVEL)) {
+        point.temp = tenths(value);
+    } else if (path_is("main.temp_min", ITEM_LEVEL)) {
+        point.temp_min = tenths(value);
+    } else if (path_is("main.temp_max", ITEM_LEVEL)) {
+        point.temp_max = tenths(value);
+    } else if (path_is("main.humidity", ITEM_LEVEL)) {
+        point.humidity = (uint8_t)strtol(value, NULL, 10);
+    } else if (path_is("pop", ITEM_LEVEL)) {
+        point.pop = (uint8_t)lroundf(strtof(value, NULL) * 100.0f);
+    } else if (path_is("weather.0.icon", ITEM_LEVEL)) {
+        strncpy(point.icon, value, sizeof(point.icon) - 1);
+        point.icon[sizeof(point.icon) - 1] = '\0';
+    }
+}
+
+// list[N] ended - deliver the point
+void ForecastJsonParser::on_close()
+{
+    if (depth() != ITEM_LEVEL + 1 || index_at(1) < 0 || strcmp(key_at(0), "list") != 0) return;
+
+    if (has_dt) {
+        points++;
+        if (on_point) on_point(point, point_ctx);
+    }
+    memset(&point, 0, sizeof(point));
+    has_dt = false;
+}
@@ -0,0 +1,217 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include "JsonStreamParser.hpp"
+
+void JsonStreamParser::reset_tokenizer()
+{
+    state = VALUE;
+    level = 0;
+    array_mask = 0;
+    value_len = 0;
+    escape = false;
+    unicode_left = 0;
+    total_bytes = 0;
+}
+
+bool JsonStreamParser::feed(const char *chunk, size_t len)
+{
+    for (size_t i = 0; i < len && state != DONE && state != ERROR; i++) {
+        if (!step(chunk[i])) state = ERROR;
+    }
+    total_bytes += len;
+    return state != ERROR;
+}
+
+bool JsonStreamParser::push(bool array)
+{
+    if (level >= MAX_NESTING) return false;
+    if (array) array_mask |= (1u << level);
+    else array_mask &= ~(1u << level);
+
+    if (level < MAX_DEPTH) {
+        frames[level].array = array;
+        frames[level].index = 0;
+        frames[level].key[0] = '\0';
+    }
+    level++;
+    return true;
+}
+
+void JsonStreamParser::pop()
+{
+    on_close();
+    level--;
+    state = (level == 0) ? DONE : AFTER_VALUE;
+}
+
+void JsonStreamParser::append(char *buf, int &len, int max, char c)
+{
+    if (len < max - 1) buf[len++] = c;     // longer values are truncated
+}
+
+// Compare the current key path with a dotted path like "weather.0.icon"
+bool JsonStreamParser::path_is(const char *path, int from) const
+{
+    if (level > MAX_DEPTH || from >= level) return false;
+    for (int d = from; d < level; d++) {
+        const char *seg = path;
+        const char *dot = strchr(path, '.');
+        size_t seg_len = dot ? (size_t)(dot - path) : strlen(path);
+
+        if (frames[d].array) {
+            if (strtoul(seg, NULL, 10) != frames[d].index || seg_len == 0 || seg[0] < '0' || seg[0] > '9') return false;
+        } else {
+            if (strncmp(frames[d].key, seg, seg_len) != 0 || frames[d].key[seg_len] != '\0') return false;
+        }
+
+        if (dot == NULL) return d == level - 1;
+        path = dot + 1;
+    }
+    return false;
+}
+
+bool JsonStreamParser::step(char c)
+{
+    bool space = (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+    Frame *top = (level > 0 && level <= MAX_DEPTH) ? &frames[level - 1] : NULL;
+
+    switch (state) {
+        case VALUE:
+            if (space) return true;
+            if (c == '{') { state = KEY_OR_END; return push(false); }
+            if (c == '[') { state = VALUE; return push(true); }
+            if (c == ']' && level > 0) { pop(); return true; }     // empty array
+            if (c == '"') { state = STRING; value_len = 0; escape = false; return true; }
+            if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+                state = LITERAL;
+                value_len = 0;
+                append(value, value_len, VALUE_LEN, c);
+                return true;
+            }
+            return false;
+
+        case KEY_OR_END:
+            if (space) return true;
+            if (c == '"') {
+                state = KEY;
+                value_len = 0;
+                escape = false;
+                return true;
+            }
+            if (c == '}') { pop(); return true; }
+            return false;
+
+        case KEY:
+            if (escape) {
+                escape = false;
+            } else if (c == '\\') {
+                escape = true;
+                return true;
+            } else if (c == '"') {
+                if (top) {
+                    memcpy(top->key, value, value_len);
+                    top->key[value_len] = '\0';
+                }
+                value_len = 0;
+                state = COLON;
+                return true;
+            }
+            append(value, value_len, KEY_LEN, c);
+            return true;
+
+        case COLON:
+            if (space) return true;
+            if (c == ':') { state = VALUE; return true; }
+            return false;
+
+        case STRING:
+            if (unicode_left) {
+                // \uXXXX - not needed for the fields we show, keep a placeholder
+                if (--unicode_left == 0) append(value, value_len, VALUE_LEN, '?');
+                return true;
+            }
+            if (escape) {
+                escape = false;
+                switch (c) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': case 'f': c = ' '; break;
+                    case 'u': unicode_left = 4; return true;
+                    default: break;     // \" \\ \/
+                }
+                append(value, value_len, VALUE_LEN, c);
+                return true;
+            }
+            if (c == '\\') { escape = true; return true; }
+            if (c == '"') {
+                emit(true);
+                state = AFTER_VALUE;
+                return true;
+            }
+            append(value, value_len, VALUE_LEN, c);
+            return true;
+
+        case LITERAL:
+            if (!(space || c == ',' || c == '}' || c == ']')) {
+                append(value, value_len, VALUE_LEN, c);
+                return true;
+            }
+            emit(false);
+            if (level == 0) { state = DONE; return true; }      // bare top level literal
+            state = AFTER_VALUE;
+            return step(c);     // the terminator belongs to the container
+
+        case AFTER_VALUE:
+            if (space) return true;
+            if (level == 0) return false;
+            if (c == ',') {
+                if (array_mask & (1u << (level - 1))) {
+                    if (top) top->index++;
+                    state = VALUE;
+                } else {
+                    state = KEY_OR_END;
+                }
+                return true;
+            }
+            if (c == '}' || c == ']') { pop(); return true; }
+            return false;
+
+        case DONE:
+        case ERROR:
+            return false;
+    }
+    return false;
+}
+
+// A scalar value is complete, hand it to the subclass
+void JsonStreamParser::emit(bool is_string)
+{
+    value[value_len] = '\0';
+    on_value(value, is_string);
+    value_len = 0;
+}
@@ -23,15 +23,28 @@ SOFTWARE.
 */
 
 #include "OpenWeatherMap.hpp"
+#include "HttpPool.hpp"
+#include <string.h>
 #include "esp_tls.h"
 #include "lwip/err.h"
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
 #include "lwip/netdb.h"
 #include "lwip/dns.h"
+#include "esp_timer.h"
 
 static const char* TAG = "OpenWeatherMap";
 
+static WeatherRefreshStats owm_stats;
+static void (*apply_lock)(void) = NULL;
+static void (*apply_unlock)(void) = NULL;
+
+// Body on its way to the parser, hashed as it passes
+struct FetchBody {
+    JsonStreamParser *parser;
+    uint32_t hash;
+};
+
 // Can Test HTTPS using Local Python server - same SSL cert used for OTA
 // extern const uint8_t local_server_cert_pem_start[] asm("_binary_ca_cert_pem_start");
 // extern const uint8_t local_server_cert_pem_end[] asm("_binary_ca_cert_pem_end");
@@ -43,22 +56,41 @@ static const char* TAG = "OpenWeatherMap";
 /*
     Free OpenWeatherAPI is available one request per min. We request once every 10mins
 
-    We pull realtime weather from the API and dump in a json local cache file (SPIFF/SDCARD/FAT)
-    Then read that file to show in the UI every 5mins. 
+    We pull realtime weather from the API, parse it while it downloads and keep the decoded
+    values in a small binary cache record (SPIFF/SDCARD/FAT), loaded straight into memory at boot.
     If device is disconnected from internet or fails, it will show the last weather update
 */
 
-#define MAX_HTTP_OUTPUT_BUFFER 1024
-
 // Move all these to config.json later
+#if defined(CONFIG_WEATHER_USE_LOCAL_SERVER)
+// Stand-in server: python3 mock_weather_server.py in the repo root
+#define WEB_API_URL     CONFIG_WEATHER_LOCAL_URL
+#define WEB_API_PORT    CONFIG_WEATHER_LOCAL_PORT
+#else
 #define WEB_API_URL     CONFIG_WEATHER_OWM_URL //"api.openweathermap.org"
-#define WEB_API_PORT    "80"    // not used unless we need custom port number
-#define WEB_API_PATH "/data/2.5/weather" //?q=" CONFIG_WEATHER_LOCATION "&units=metric&APPID="
+#define WEB_API_PORT    80
+#endif
+#define WEB_API_BASE    "/data/2.5/"
+
+// units = standard / metric / imperial
+// https://openweathermap.org/weather-data
+#if defined(CONFIG_WEATHER_UNITS_METRIC)    
+#define WEB_API_UNITS   "&units=metric"
+#elif defined(CONFIG_WEATHER_UNITS_IMPERIAL)
+#define WEB_API_UNITS   "&units=imperial"
+#else   // Standard => Kelvin?
+#define WEB_API_UNITS   ""
+#endif
 
-OpenWeatherMap::OpenWeatherMap()
+OpenWeatherMap::OpenWeatherMap(const string &location, const string &cache_file, const string &seed_json)
 {
-    // Weather cache filename
-    file_name = "/spiffs/weather/weather.json";
+    Location = location;
+    file_name = cache_file;
+    json_name = seed_json;
+    UpdatedAt = 0;
+    changed = 0;
+    memset(&current, 0, sizeof(current));
+    memset(&fetch_state, 0, sizeof(fetch_state));
 
     // Settings filename / add these after UI has these config options
     // cfg_filename = "/spiffs/settings.json";
@@ -73,6 +105,9 @@ OpenWeatherMap::OpenWeatherMap()
 #else   // Standard => Kelvin
     TemperatureUnit = 'K';  // degree symbol not used
 #endif
+
+    // Last known weather is on screen from the first frame, before wifi is up
+    load_cache();
 }
 
 /* 
@@ -80,123 +115,134 @@ OpenWeatherMap::OpenWeatherMap()
  * API call can fail => no wifi / connectivity issues / request limits
  * If fails, data from cache file is used.
 */
-void OpenWeatherMap::request_weather_update()
+bool OpenWeatherMap::request_weather_update()
 {
-    jsonString = "";
+    // Body is parsed while it is downloaded, only the decoded record hits the flash
+    esp_err_t err = request_json_over_http();
+    if (err == ESP_OK && fetch_state.not_modified) {
+        ESP_LOGI(TAG,"Weather not modified - %s", Location.c_str());
+        UpdatedAt = time(NULL);
+        return true;
+    }
+    if (err == ESP_OK && parser.complete()) {
+        ESP_LOGI(TAG,"Weather updated - %s (%u bytes)", Location.c_str(), parser.bytes());
+        update(parser.data());
+        return true;
+    }
+
+    // In-memory values are already the last good update, reload only if we never had one
+    if (UpdatedAt == 0) {
+        ESP_LOGW(TAG,"Weather request failed, reading cache - %s", file_name.c_str());
+        load_cache();
+    } else {
+        ESP_LOGW(TAG,"Weather request failed, keeping last update");
+    }
+    return false;
+}
 
-    // Get weather from OpenWeatherMap and update the cache file
-    if (request_json_over_http() == ESP_OK) {
-        ESP_LOGI(TAG,"Updating and writing into cache - weather.json");
-        write_json();    // Save content of jsonString to file if success
+uint32_t OpenWeatherMap::update(const WeatherData &data)
+{
+    uint32_t diff = weather_data_diff(current, data);
+    UpdatedAt = time(NULL);
+
+    // Same values - nothing to redraw and no reason to wear the flash
+    if (diff == 0) {
+        owm_stats.unchanged++;
+        owm_stats.writes_skipped++;
+        ESP_LOGI(TAG,"Weather unchanged - %s, cache write skipped (%" PRIu32 " so far)",
+                    Location.c_str(), owm_stats.writes_skipped);
+        return 0;
     }
-    ESP_LOGI(TAG,"Reading - weather.json");
-    read_json();
 
-    ESP_LOGI(TAG,"Loading - weather.json");
-    load_json();
+    if (apply_lock) apply_lock();
+    apply(data);
+    __atomic_fetch_or(&changed, diff, __ATOMIC_ACQ_REL);
+    if (apply_unlock) apply_unlock();
+
+    int64_t start = esp_timer_get_time();
+    size_t written = weather_cache_save(file_name.c_str(), data);
+    const WeatherCacheStats &st = weather_cache_stats();
+    ESP_LOGI(TAG,"Cache saved: %u bytes in %" PRId64 "us - %" PRIu32 " writes / %" PRIu32 " bytes since boot",
+                written, esp_timer_get_time() - start, st.writes, st.bytes_written);
+    return diff;
 }
 
-void OpenWeatherMap::load_json()
+bool OpenWeatherMap::load_cache()
 {
-    ESP_LOGW(TAG,"load_json() \n%s",jsonString.c_str());
+    WeatherData data;
+    int64_t saved_at = 0;
+
+    int64_t start = esp_timer_get_time();
+    if (weather_cache_load(file_name.c_str(), &data, &saved_at)) {
+        int64_t elapsed = esp_timer_get_time() - start;
+        apply(data);
+        changed = ~0u;
+        UpdatedAt = (time_t)saved_at;
+        ESP_LOGI(TAG,"Cache loaded: %u bytes in %" PRId64 "us, saved at %" PRId64,
+                    sizeof(WeatherCacheHeader) + sizeof(WeatherData), elapsed, saved_at);
+        return true;
+    }
 
-    // try
-	// {
+    // First boot - the seed json from the flash image
+    if (json_name.empty()) return false;
+    start = esp_timer_get_time();
+    bool ok = read_json();
+    ESP_LOGI(TAG,"Seed json %s in %" PRId64 "us", ok ? "parsed" : "failed", esp_timer_get_time() - start);
+    return ok;
+}
+
+void OpenWeatherMap::apply(const WeatherData &data)
+{
+    current = data;
 
     // 19.8°С temperature from 18.9°С to 19.8 °С, wind 1.54 m/s. clouds 20 %, 1017 hpa
-    root = cJSON_Parse(jsonString.c_str());
-
-    // name = Bengaluru / What we searched?
-    LocationName = cJSON_GetObjectItem(root,"name")->valuestring;
-    int root_visibility = cJSON_GetObjectItem(root,"visibility")->valueint;
-    ESP_LOGW(TAG,"root: %s / %d",LocationName.c_str(), root_visibility);
-
-    maininfo = cJSON_GetObjectItem(root,"main");
-    Temperature = cJSON_GetObjectItem(maininfo,"temp")->valuedouble;
-    TemperatureFeelsLike = cJSON_GetObjectItem(maininfo,"feels_like")->valuedouble;
-    TemperatureLow = cJSON_GetObjectItem(maininfo,"temp_min")->valuedouble;
-    TemperatureHigh = cJSON_GetObjectItem(maininfo,"temp_max")->valuedouble;
-    Pressure = cJSON_GetObjectItem(maininfo,"pressure")->valueint;
-    Humidity = cJSON_GetObjectItem(maininfo,"humidity")->valueint;
-    
+    LocationName = data.name;
+    Temperature = data.temp;
+    TemperatureFeelsLike = data.feels_like;
+    TemperatureLow = data.temp_min;
+    TemperatureHigh = data.temp_max;
+    Pressure = data.pressure;
+    Humidity = data.humidity;
+    SeaLevel = data.sea_level;
+    GroundLevel = data.grnd_level;
+    WeatherIcon = data.icon;
+
+    ESP_LOGW(TAG,"root: %s / %" PRId32, data.name, data.visibility);
     ESP_LOGW(TAG,"main: %3.1f°С / %3.1f°С / %3.1f°С / %3.1f°С / %d / %dhpa",
                                             Temperature, TemperatureFeelsLike,
                                             TemperatureLow, TemperatureHigh,
                                             Pressure,Humidity);
-
-/*    
-    SeaLevel = cJSON_GetObjectItem(maininfo,"sea_level")->valueint;
-    GroundLevel = cJSON_GetObjectItem(maininfo,"grnd_level")->valueint;
-*/
-
-
-    // 1st element of the weather array. 
-    // Guess for free api version only 1 (single day) available
-    weather = cJSON_GetArrayItem(cJSON_GetObjectItem(root,"weather"),0);
-    string weather_main = cJSON_GetObjectItem(weather,"main")->valuestring;
-    string weather_description = cJSON_GetObjectItem(weather,"description")->valuestring;
-    WeatherIcon = cJSON_GetObjectItem(weather,"icon")->valuestring;
-    ESP_LOGW(TAG,"weather: %s / %s / %s",weather_main.c_str(), weather_description.c_str(),WeatherIcon.c_str());
-
-    // lon / lat
-    coord = cJSON_GetObjectItem(root,"coord");
-    double coord_lon = cJSON_GetObjectItem(coord,"lon")->valuedouble;
-    double coord_lat = cJSON_GetObjectItem(coord,"lat")->valuedouble;
-    ESP_LOGW(TAG,"coord: %f / %f ",coord_lon, coord_lat);
-
-    // all = 20 ???
-    //clouds = cJSON_GetObjectItem(root,"clouds");
-
-    // speed / degree
-    wind = cJSON_GetObjectItem(root,"wind");
-    double wind_speed = cJSON_GetObjectItem(wind,"speed")->valuedouble;
-    int wind_deg = cJSON_GetObjectItem(wind,"deg")->valueint;
-    ESP_LOGW(TAG,"wind: %3.1f m/s / %d ",wind_speed, wind_deg);
-
-    // type / id / country / sunrise (epoc?) / sunset (epoc?)
-    //sys = cJSON_GetObjectItem(root,"sys");
-
-	// }
-	// catch (exception& exc)
-	// {
-	// 	ESP_LOGE(TAG,"Exception has occurred!");
-	// }
-
-    // Cleanup
-    cJSON_Delete(root);
+    ESP_LOGW(TAG,"weather: %s / %s / %s",data.main, data.description, data.icon);
+    ESP_LOGW(TAG,"coord: %f / %f ",data.lon, data.lat);
+    ESP_LOGW(TAG,"wind: %3.1f m/s / %" PRId32, data.wind_speed, data.wind_deg);
 }
 
-void OpenWeatherMap::read_json()
+bool OpenWeatherMap::read_json()
 {
-    // read json file to string    
-    ifstream jsonfile(file_name);
-    if (!jsonfile.is_open())
+    // Stream the json file through the parser - no copy of the file in memory
+    FILE *f = fopen(json_name.c_str(), "r");
+    if (f == NULL)
     {
-        ESP_LOGE(TAG,"File open for read failed %s",file_name.c_str());
-        //save_config();  // create file with default values
+        ESP_LOGE(TAG,"File open for read failed %s",json_name.c_str());
+        return false;
     }
 
-    jsonString.assign((std::istreambuf_iterator<char>(jsonfile)),
-                (std::istreambuf_iterator<char>()));
+    char buf[256];
+    size_t len;
+    parser.reset();
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0 && parser.feed(buf, len)) { }
+    fclose(f);
 
-    jsonfile.close();    
-}
-
-void OpenWeatherMap::write_json()
-{
-    // cache json in flash to show if not online?
-    ofstream jsonfile(file_name);
-    if (!jsonfile.is_open())
-    {
-        ESP_LOGE(TAG,"File open for write failed %s",file_name.c_str());
-        return ;//ESP_FAIL;
+    if (!parser.complete()) {
+        ESP_LOGE(TAG,"%s is not a valid weather response", json_name.c_str());
+        return false;
     }
-    jsonfile << jsonString;
-    jsonfile.flush();
-    jsonfile.close();    
+    apply(parser.data());
+    changed = ~0u;
+    return true;
 }
 
-esp_err_t http_event_handle(esp_http_client_event_t *evt)
+static esp_err_t http_event_handle(esp_http_client_event_t *evt)
 {
     static int output_len;       // Stores number of bytes read
     switch(evt->event_id) {
@@ -210,21 +256,21 @@ esp_err_t http_event_handle(esp_http_client_event_t *evt)
             ESP_LOGI(TAG, "HTTP_EVENT_HEADER_SENT");
             break;
         case HTTP_EVENT_ON_HEADER:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_HEADER");
-            printf("%.*s", evt->data_len, (char*)evt->data);
+            ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER %s: %s", evt->header_key, evt->header_value);
             break;
         case HTTP_EVENT_ON_DATA:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            if (!esp_http_client_is_chunked_response(evt->client)) {
-                // If user_data buffer is configured, copy the response into the buffer
-                if (evt->user_data) {
-                    memcpy(evt->user_data + output_len, evt->data, evt->data_len);
-                }
-                output_len += evt->data_len;
-            }            
+            ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
+            // Chunked or not, every piece goes straight to the parser.
+            // Error responses (401 bad key, 429 rate limit..) are not weather
+            if (evt->user_data && esp_http_client_get_status_code(evt->client) == 200) {
+                FetchBody *body = (FetchBody *)evt->user_data;
+                const uint8_t *p = (const uint8_t *)evt->data;
+                for (int i = 0; i < evt->data_len; i++) body->hash = (body->hash ^ p[i]) * 16777619u;
+                body->parser->feed((const char *)evt->data, evt->data_len);
+            }
+            output_len += evt->data_len;
             break;
         case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH");
             ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH, Total len=%d", output_len);
             output_len = 0;
             break;
@@ -248,50 +294,75 @@ esp_err_t OpenWeatherMap::request_json_over_https()
     return ESP_OK;
 }
 
+string OpenWeatherMap::api_path(const char *endpoint, const string &params)
+{
+    string path = WEB_API_BASE;
+    path += endpoint;
+    path += "?";
+    path += params;
+    path += WEB_API_UNITS "&APPID=" CONFIG_WEATHER_API_KEY;
+    return path;
+}
+
+esp_err_t OpenWeatherMap::fetch(const string &path, JsonStreamParser &parser, WeatherFetchState *state)
+{
+    ESP_LOGD(TAG,"URL: http://%s:%d%s", WEB_API_URL, WEB_API_PORT, path.c_str());
+
+    // Pooled client - keeps the socket and the resolved address between refreshes
+    FetchBody body = { &parser, 2166136261u };
+    HttpTiming timing;
+    esp_err_t err = HttpPool::instance().get(WEB_API_URL, WEB_API_PORT, path.c_str(),
+                                             http_event_handle, &body, &timing,
+                                             state ? &state->validators : NULL);
+    if (state) state->not_modified = false;
+    if (err != ESP_OK) return err;
+
+    if (timing.status == 304 && state) {
+        owm_stats.not_modified++;
+        state->not_modified = true;
+        return ESP_OK;
+    }
+    if (timing.status != 200) {
+        ESP_LOGW(TAG,"HTTP status %d", timing.status);
+        return ESP_FAIL;
+    }
+
+    // Server without validators - the body itself tells if anything is new
+    if (state) {
+        state->not_modified = (body.hash == state->body_hash);
+        if (state->not_modified) owm_stats.same_body++;
+        state->body_hash = body.hash;
+    }
+    return ESP_OK;
+}
+
+const WeatherRefreshStats &OpenWeatherMap::refresh_stats()
+{
+    return owm_stats;
+}
+
+void OpenWeatherMap::set_apply_lock(void (*lock)(void), void (*unlock)(void))
+{
+    apply_lock = lock;
+    apply_unlock = unlock;
+}
+
 /*
     Get OpenWeatherMaps json using http - api.openweathermap.org
 */
 esp_err_t OpenWeatherMap::request_json_over_http()
 {
-    char local_response_buffer[MAX_HTTP_OUTPUT_BUFFER] = {0};
-
-    jsonString = "";
-    string queryString = "";
-
-    // units = standard / metric / imperial
-    // https://openweathermap.org/weather-data
-    #if defined(CONFIG_WEATHER_UNITS_METRIC)    
-            queryString = WEB_API_PATH "?q=" CONFIG_WEATHER_LOCATION "&units=metric&APPID=" CONFIG_WEATHER_API_KEY;
-    #elif defined(CONFIG_WEATHER_UNITS_IMPERIAL)
-            queryString = WEB_API_PATH "?q=" CONFIG_WEATHER_LOCATION "&units=imperial&APPID=" CONFIG_WEATHER_API_KEY;
-    #else   // Standard => Kelvin?
-            queryString = WEB_API_PATH "?q=" CONFIG_WEATHER_LOCATION "&APPID=" CONFIG_WEATHER_API_KEY;
-    #endif
-
     ESP_LOGI(TAG, "HTTP request to get weather");
-    ESP_LOGE(TAG,"URL: http://api.openweathermap.org%s",queryString.c_str());
-
-    esp_http_client_config_t config = {
-        .host = WEB_API_URL,
-        .path = queryString.c_str(),
-        .event_handler = http_event_handle,
-        .user_data = local_response_buffer,        // Pass address of local buffer to get response
-    };
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
-
-    if (err == ESP_OK) {
-    ESP_LOGI(TAG, "Status = %d, content_length = %" PRId64 , // PRIu64  / PRIx64 to print in hexadecimal.
-            esp_http_client_get_status_code(client),
-            esp_http_client_get_content_length(client));
-    } else {
-        return ESP_FAIL;
-    }
 
-    esp_http_client_cleanup(client);    
-    //ESP_LOGE(TAG,"JSON:\n%s",local_response_buffer);
-    jsonString = local_response_buffer;
-    return ESP_OK;
+    // Location may have spaces - "New York,US"
+    string query = "q=";
+    for (char c : Location) {
+        if (c == ' ') query += "%20";
+        else query += c;
+    }
 
-}
\ No newline at end of file
+    parser.reset();
+    esp_err_t err = fetch(api_path("weather", query), parser, &fetch_state);
+    if (err == ESP_OK && fetch_state.not_modified) return ESP_OK;
+    return (err == ESP_OK && parser.complete()) ? ESP_OK : ESP_FAIL;
+}
@@ -0,0 +1,129 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "WeatherCache.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+static const char* TAG = "WeatherCache";
+
+static WeatherCacheStats cache_stats;
+
+static uint32_t weather_cache_crc(const WeatherData &data)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&data, sizeof(WeatherData));
+}
+
+static bool weather_cache_read(const char *path, WeatherData *data, int64_t *saved_at)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+
+    WeatherCacheHeader hdr;
+    WeatherData tmp;
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1
+           && hdr.magic == WEATHER_CACHE_MAGIC
+           && hdr.version == WEATHER_CACHE_VERSION
+           && hdr.size == sizeof(WeatherData)
+           && fread(&tmp, sizeof(tmp), 1, f) == 1
+           && hdr.crc == weather_cache_crc(tmp);
+    fclose(f);
+
+    if (!ok) {
+        ESP_LOGW(TAG,"Ignoring invalid cache record %s", path);
+        return false;
+    }
+
+    *data = tmp;
+    if (saved_at) *saved_at = hdr.saved_at;
+    return true;
+}
+
+size_t weather_cache_save(const char *path, const WeatherData &data)
+{
+    std::string tmp_name = std::string(path) + ".tmp";
+
+    WeatherCacheHeader hdr = {};
+    hdr.magic = WEATHER_CACHE_MAGIC;
+    hdr.version = WEATHER_CACHE_VERSION;
+    hdr.size = sizeof(WeatherData);
+    hdr.saved_at = time(NULL);
+    hdr.crc = weather_cache_crc(data);
+
+    FILE *f = fopen(tmp_name.c_str(), "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG,"File open for write failed %s", tmp_name.c_str());
+        return 0;
+    }
+
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1
+           && fwrite(&data, sizeof(data), 1, f) == 1
+           && fflush(f) == 0
+           && fsync(fileno(f)) == 0;     // on flash before the old record goes
+    fclose(f);
+
+    if (!ok) {
+        ESP_LOGE(TAG,"Cache write failed %s", tmp_name.c_str());
+        unlink(tmp_name.c_str());
+        return 0;
+    }
+
+    unlink(path);   // SPIFFS rename doesn't replace, load() recovers the .tmp if we stop here
+    if (rename(tmp_name.c_str(), path) != 0) {
+        ESP_LOGE(TAG,"Cache rename failed %s", path);
+        return 0;
+    }
+
+    cache_stats.writes++;
+    cache_stats.bytes_written += sizeof(hdr) + sizeof(data);
+    return sizeof(hdr) + sizeof(data);
+}
+
+bool weather_cache_load(const char *path, WeatherData *data, int64_t *saved_at)
+{
+    cache_stats.loads++;
+    if (weather_cache_read(path, data, saved_at)) return true;
+
+    // Power cut between unlink and rename - the complete .tmp is the latest record
+    std::string tmp_name = std::string(path) + ".tmp";
+    if (weather_cache_read(tmp_name.c_str(), data, saved_at)) {
+        ESP_LOGW(TAG,"Recovered cache record from %s", tmp_name.c_str());
+        unlink(path);
+        rename(tmp_name.c_str(), path);
+        return true;
+    }
+
+    cache_stats.load_failures++;
+    return false;
+}
+
+const WeatherCacheStats &weather_cache_stats()
+{
+    return cache_stats;
+}
@@ -0,0 +1,372 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "WeatherEngine.hpp"
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char* TAG = "WeatherEngine";
+
+#define US_PER_SEC          1000000LL
+#define CURRENT_INTERVAL_US ((int64_t)CONFIG_WEATHER_CURRENT_INTERVAL * US_PER_SEC)
+#define FORECAST_INTERVAL_US ((int64_t)CONFIG_WEATHER_FORECAST_INTERVAL * US_PER_SEC)
+#define STARTUP_SPACING_US  (5 * US_PER_SEC)    // first requests after boot
+#define RETRY_US            (60 * US_PER_SEC)   // doubled per failure, up to the interval
+#define TOKEN_BURST         2.0f
+#define GROUP_MAX_FAILURES  3                   // then back to single requests
+#define CLOCK_VALID         1600000000          // time() before this - clock not set yet
+
+WeatherEngine::WeatherEngine()
+{
+    locations = 0;
+    listener = NULL;
+    listener_ctx = NULL;
+    tokens = TOKEN_BURST;
+    tokens_at_us = esp_timer_get_time();
+    group_failures = 0;
+    memset(&group_state, 0, sizeof(group_state));
+    fc_loc = -1;
+    memset(&fc_day, 0, sizeof(fc_day));
+    memset(&engine_stats, 0, sizeof(engine_stats));
+
+    // "London,GB;Tokyo,JP" after the main location
+    string list = CONFIG_WEATHER_LOCATION ";" CONFIG_WEATHER_EXTRA_LOCATIONS;
+    size_t pos = 0;
+    while (pos <= list.size() && locations < WEATHER_MAX_LOCATIONS) {
+        size_t end = list.find(';', pos);
+        if (end == string::npos) end = list.size();
+        string name = list.substr(pos, end - pos);
+        pos = end + 1;
+        if (name.empty()) continue;
+
+        WeatherLocation &l = loc[locations];
+        if (locations == 0) {
+            l.current = new OpenWeatherMap(name);   // keeps weather.bin and the seed json
+        } else {
+            l.current = new OpenWeatherMap(name, "/spiffs/weather/weather_" + to_string(locations) + ".bin", "");
+        }
+
+        // Spread the first requests, forecasts after all current conditions
+        int64_t now = esp_timer_get_time();
+        l.next_current_us = now + locations * STARTUP_SPACING_US;
+        l.next_forecast_us = now + (WEATHER_MAX_LOCATIONS + locations) * STARTUP_SPACING_US;
+        l.failures = 0;
+        l.stable_current = 0;
+        l.stable_forecast = 0;
+        memset(&l.forecast_state, 0, sizeof(l.forecast_state));
+        locations++;
+    }
+    ESP_LOGI(TAG,"%d location(s), current every %ds, forecast every %ds, max %d requests/min",
+                locations, CONFIG_WEATHER_CURRENT_INTERVAL, CONFIG_WEATHER_FORECAST_INTERVAL,
+                CONFIG_WEATHER_MAX_REQ_PER_MIN);
+}
+
+bool WeatherEngine::take_token(int64_t now)
+{
+    tokens += (float)(now - tokens_at_us) * CONFIG_WEATHER_MAX_REQ_PER_MIN / (60.0f * US_PER_SEC);
+    if (tokens > TOKEN_BURST) tokens = TOKEN_BURST;
+    tokens_at_us = now;
+
+    if (tokens < 1.0f) return false;
+    tokens -= 1.0f;
+    return true;
+}
+
+uint32_t WeatherEngine::poll()
+{
+    int64_t now = esp_timer_get_time();
+
+    // Most overdue piece of work
+    int cur = -1, fc = -1;
+    for (int i = 0; i < locations; i++) {
+        if (loc[i].next_current_us <= now && (cur < 0 || loc[i].next_current_us < loc[cur].next_current_us)) cur = i;
+        if (loc[i].next_forecast_us <= now && (fc < 0 || loc[i].next_forecast_us < loc[fc].next_forecast_us)) fc = i;
+    }
+
+    if (cur >= 0 || fc >= 0) {
+        if (!take_token(now)) {
+            engine_stats.throttled++;
+        } else if (cur >= 0) {
+            // Current conditions first - that's what is on screen
+            if (due_group(now, CURRENT_INTERVAL_US / 4) < 2) {
+                refresh_current(cur, now);
+            } else if (!refresh_group(now) && take_token(now)) {
+                refresh_current(cur, now);
+            }
+        } else {
+            refresh_forecast(fc, now);
+        }
+    }
+
+    // Sleep until the next item is due, or the next token if throttled
+    now = esp_timer_get_time();
+    int64_t next = now + CURRENT_INTERVAL_US;
+    for (int i = 0; i < locations; i++) {
+        if (loc[i].next_current_us < next) next = loc[i].next_current_us;
+        if (loc[i].next_forecast_us < next) next = loc[i].next_forecast_us;
+    }
+    int64_t wait_ms = (next - now) / 1000;
+    if (tokens < 1.0f) {
+        int64_t token_ms = (int64_t)((1.0f - tokens) * 60000.0f / CONFIG_WEATHER_MAX_REQ_PER_MIN);
+        if (wait_ms < token_ms) wait_ms = token_ms;
+    }
+    return (uint32_t)(wait_ms < 1000 ? 1000 : wait_ms);
+}
+
+// Locations with a known city id whose refresh is due within the window
+int WeatherEngine::due_group(int64_t now, int64_t window)
+{
+#if defined(CONFIG_WEATHER_GROUP_REQUESTS)
+    if (group_failures >= GROUP_MAX_FAILURES) return 0;
+    int n = 0;
+    for (int i = 0; i < locations; i++) {
+        if (loc[i].current->data().id && loc[i].next_current_us <= now + window) n++;
+    }
+    return n;
+#else
+    return 0;
+#endif
+}
+
+bool WeatherEngine::refresh_group(int64_t now)
+{
+    int64_t window = CURRENT_INTERVAL_US / 4;
+    string ids = "id=";
+    uint32_t wanted = 0;
+    for (int i = 0; i < locations; i++) {
+        const WeatherData &d = loc[i].current->data();
+        if (d.id == 0 || loc[i].next_current_us > now + window) continue;
+        if (wanted) ids += ",";
+        ids += to_string(d.id);
+        wanted |= 1u << i;
+    }
+
+    engine_stats.requests++;
+    engine_stats.group_requests++;
+
+    group_seen = 0;
+    group_changed = 0;
+    group_parser.reset();
+    group_parser.set_list_handler(on_group_item, this);
+    esp_err_t err = OpenWeatherMap::fetch(OpenWeatherMap::api_path("group", ids), group_parser, &group_state);
+    group_parser.set_list_handler(NULL, NULL);
+    if (err == ESP_OK && group_state.not_modified && group_seen == 0) {
+        group_seen = wanted;    // 304 - everyone's values still hold
+    }
+
+    if (err != ESP_OK || group_seen == 0) {
+        engine_stats.failures++;
+        group_failures++;
+        ESP_LOGW(TAG,"Group request failed (%d/%d)", group_failures, GROUP_MAX_FAILURES);
+        return false;   // caller falls back to a single request
+    }
+    group_failures = 0;
+
+    // Missing from the response - they get a single request on their next turn
+    for (int i = 0; i < locations; i++) {
+        if (!(wanted & (1u << i))) continue;
+        finished(i, (group_seen & (1u << i)) != 0, (group_changed & (1u << i)) != 0,
+                 &loc[i].next_current_us, &loc[i].stable_current, CURRENT_INTERVAL_US, now);
+        if ((group_seen & (1u << i)) && !(group_changed & (1u << i))) notify(i, 0);
+    }
+    ESP_LOGI(TAG,"Group request refreshed %d location(s)", __builtin_popcount(group_seen));
+    return true;
+}
+
+void WeatherEngine::on_group_item(int index, const WeatherData &data, void *ctx)
+{
+    WeatherEngine *self = (WeatherEngine *)ctx;
+    for (int i = 0; i < self->locations; i++) {
+        if (self->loc[i].current->data().id != data.id) continue;
+
+        uint32_t changed = self->loc[i].current->update(data);
+        self->group_seen |= 1u << i;
+        self->engine_stats.batched++;
+        if (changed) {
+            self->group_changed |= 1u << i;
+            self->notify(i, changed);
+        }
+        break;
+    }
+}
+
+bool WeatherEngine::refresh_current(int i, int64_t now)
+{
+    engine_stats.requests++;
+
+    OpenWeatherMap *owm = loc[i].current;
+    WeatherData before = owm->data();
+    bool ok = owm->request_weather_update();
+    uint32_t changed = ok ? weather_data_diff(before, owm->data()) : 0;
+    if (ok) notify(i, changed);
+    else engine_stats.failures++;
+
+    finished(i, ok, changed != 0, &loc[i].next_current_us, &loc[i].stable_current, CURRENT_INTERVAL_US, now);
+    return ok;
+}
+
+bool WeatherEngine::refresh_forecast(int i, int64_t now)
+{
+    engine_stats.requests++;
+    engine_stats.forecast_requests++;
+
+    const WeatherData &cur = loc[i].current->data();
+    string query;
+    if (cur.id) {
+        query = "id=" + to_string(cur.id);
+    } else {
+        query = "q=";
+        for (char c : loc[i].current->Location) {
+            if (c == ' ') query += "%20";
+            else query += c;
+        }
+    }
+    query += "&cnt=40";     // 5 days, enough for the daily series
+
+    fc_loc = i;
+    fc_tz = (cur.fields & WF_TIMEZONE) ? cur.timezone : 0;
+    fc_changed = 0;
+    fc_first_dt = 0;
+    fc_day.dt = 0;
+    forecast_parser.reset();
+    forecast_parser.set_handler(on_forecast_point, this);
+    WeatherFetchState &state = loc[i].forecast_state;
+    esp_err_t err = OpenWeatherMap::fetch(OpenWeatherMap::api_path("forecast", query), forecast_parser, &state);
+    bool ok = err == ESP_OK && (state.not_modified || forecast_parser.complete());
+    if (ok && !state.not_modified) flush_day();
+    forecast_parser.set_handler(NULL, NULL);
+    fc_loc = -1;
+
+    // Past steps and days drop off the front
+    time_t wall = time(NULL);
+    if (wall > CLOCK_VALID) {
+        if (loc[i].hourly.prune((uint32_t)wall - 3 * 3600)) fc_changed |= WEATHER_CHANGED_HOURLY;
+        if (loc[i].daily.prune((uint32_t)wall - 24 * 3600)) fc_changed |= WEATHER_CHANGED_DAILY;
+    }
+
+    if (ok && state.not_modified) {
+        ESP_LOGI(TAG,"Forecast %s not modified", loc[i].current->Location.c_str());
+        notify(i, fc_changed);
+    } else if (ok) {
+        ESP_LOGI(TAG,"Forecast %s: %d steps (%u bytes), %u hourly / %u daily kept",
+                    loc[i].current->Location.c_str(), forecast_parser.count(), forecast_parser.bytes(),
+                    loc[i].hourly.size(), loc[i].daily.size());
+        notify(i, fc_changed);
+        report();
+    } else {
+        engine_stats.failures++;
+    }
+
+    finished(i, ok, fc_changed != 0, &loc[i].next_forecast_us, &loc[i].stable_forecast, FORECAST_INTERVAL_US, now);
+    return ok;
+}
+
+void WeatherEngine::on_forecast_point(const ForecastPoint &point, void *ctx)
+{
+    WeatherEngine *self = (WeatherEngine *)ctx;
+    WeatherLocation &l = self->loc[self->fc_loc];
+
+    // Hourly series is the next steps only, the rest of the 5 days goes into daily
+    if (self->fc_first_dt == 0) self->fc_first_dt = point.dt;
+    if (point.dt < self->fc_first_dt + WEATHER_HOURLY_POINTS * 3 * 3600 && l.hourly.put(point)) {
+        self->fc_changed |= WEATHER_CHANGED_HOURLY;
+    }
+
+    // Fold the step into its local day
+    int64_t local = (int64_t)point.dt + self->fc_tz;
+    uint32_t day = (uint32_t)(local - local % 86400 - self->fc_tz);
+    int noon_dist = abs((int)(local % 86400) - 12 * 3600);
+
+    if (self->fc_day.dt != day) {
+        self->flush_day();
+        self->fc_day.dt = day;
+        self->fc_day.temp_min = point.temp_min;
+        self->fc_day.temp_max = point.temp_max;
+        self->fc_day.pop = point.pop;
+        memcpy(self->fc_day.icon, point.icon, sizeof(point.icon));
+        self->fc_day_noon_dist = noon_dist;
+        return;
+    }
+    if (point.temp_min < self->fc_day.temp_min) self->fc_day.temp_min = point.temp_min;
+    if (point.temp_max > self->fc_day.temp_max) self->fc_day.temp_max = point.temp_max;
+    if (point.pop > self->fc_day.pop) self->fc_day.pop = point.pop;
+    if (noon_dist < self->fc_day_noon_dist) {
+        memcpy(self->fc_day.icon, point.icon, sizeof(point.icon));
+        self->fc_day_noon_dist = noon_dist;
+    }
+}
+
+void WeatherEngine::flush_day()
+{
+    if (fc_day.dt == 0) return;
+    if (loc[fc_loc].daily.put(fc_day)) fc_changed |= WEATHER_CHANGED_DAILY;
+    fc_day.dt = 0;
+}
+
+// Reschedule - on success the interval, stretched while the data stays the same.
+// On failure a growing retry delay, never longer than the interval
+void WeatherEngine::finished(int i, bool ok, bool changed, int64_t *next, uint8_t *stable,
+                             int64_t interval_us, int64_t now)
+{
+    if (ok) {
+        loc[i].failures = 0;
+        if (changed) *stable = 0;
+        else if (*stable < CONFIG_WEATHER_BACKOFF_MAX - 1) (*stable)++;
+        *next = now + interval_us * (1 + *stable);
+        return;
+    }
+    if (loc[i].failures < 8) loc[i].failures++;
+    int64_t retry = RETRY_US << (loc[i].failures - 1);
+    *next = now + (retry < interval_us ? retry : interval_us);
+}
+
+void WeatherEngine::notify(int i, uint32_t changed)
+{
+    if (changed == 0) {
+        engine_stats.updates_unchanged++;
+        return;
+    }
+    if (listener) listener(i, changed, listener_ctx);
+}
+
+void WeatherEngine::report()
+{
+    const WeatherEngineStats &s = engine_stats;
+    const WeatherRefreshStats &r = OpenWeatherMap::refresh_stats();
+    ESP_LOGI(TAG,"requests %" PRIu32 " (group %" PRIu32 " covering %" PRIu32 ", forecast %" PRIu32 ") / failed %" PRIu32 " / throttled %" PRIu32,
+                s.requests, s.group_requests, s.batched, s.forecast_requests,
+                s.failures, s.throttled);
+    ESP_LOGI(TAG,"not modified %" PRIu32 " / same body %" PRIu32 " / same values %" PRIu32 " - cache writes skipped %" PRIu32 " / redraws skipped %" PRIu32,
+                r.not_modified, r.same_body, r.unchanged, r.writes_skipped, s.updates_unchanged);
+    for (int i = 0; i < locations; i++) {
+        ESP_LOGI(TAG,"  %s: next current in %llds (x%d), forecast in %llds (x%d), %u hourly / %u daily",
+                    loc[i].current->Location.c_str(),
+                    (loc[i].next_current_us - esp_timer_get_time()) / US_PER_SEC, 1 + loc[i].stable_current,
+                    (loc[i].next_forecast_us - esp_timer_get_time()) / US_PER_SEC, 1 + loc[i].stable_forecast,
+                    loc[i].hourly.size(), loc[i].daily.size());
+    }
+}
@@ -0,0 +1,136 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include "WeatherJsonParser.hpp"
+
+#define ITEM_LEVEL  2       // list.N.<field> in a group response
+
+enum FieldType : uint8_t { FT_STR, FT_FLOAT, FT_INT, FT_INT64 };
+
+struct FieldMap {
+    const char *path;           // dotted path, array elements by index
+    FieldType type;
+    size_t offset;
+    size_t size;
+    uint32_t bit;
+};
+
+#define WF(path, type, member, bit) { path, type, offsetof(WeatherData, member), sizeof(WeatherData::member), bit }
+
+static const FieldMap field_map[] = {
+    WF("name",                  FT_STR,   name,        WF_NAME),
+    WF("main.temp",             FT_FLOAT, temp,        WF_TEMP),
+    WF("main.feels_like",       FT_FLOAT, feels_like,  WF_FEELS_LIKE),
+    WF("main.temp_min",         FT_FLOAT, temp_min,    WF_TEMP_MIN),
+    WF("main.temp_max",         FT_FLOAT, temp_max,    WF_TEMP_MAX),
+    WF("main.pressure",         FT_INT,   pressure,    WF_PRESSURE),
+    WF("main.humidity",         FT_INT,   humidity,    WF_HUMIDITY),
+    WF("main.sea_level",        FT_INT,   sea_level,   WF_SEA_LEVEL),
+    WF("main.grnd_level",       FT_INT,   grnd_level,  WF_GRND_LEVEL),
+    WF("visibility",            FT_INT,   visibility,  WF_VISIBILITY),
+    WF("weather.0.main",        FT_STR,   main,        WF_MAIN),
+    WF("weather.0.description", FT_STR,   description, WF_DESCRIPTION),
+    WF("weather.0.icon",        FT_STR,   icon,        WF_ICON),
+    WF("coord.lon",             FT_FLOAT, lon,         WF_LON),
+    WF("coord.lat",             FT_FLOAT, lat,         WF_LAT),
+    WF("wind.speed",            FT_FLOAT, wind_speed,  WF_WIND_SPEED),
+    WF("wind.deg",              FT_INT,   wind_deg,    WF_WIND_DEG),
+    WF("dt",                    FT_INT64, dt,          WF_DT),
+    WF("cod",                   FT_INT,   cod,         WF_COD),
+    WF("id",                    FT_INT,   id,          WF_ID),
+    WF("timezone",              FT_INT,   timezone,    WF_TIMEZONE),
+};
+
+uint32_t weather_data_diff(const WeatherData &a, const WeatherData &b)
+{
+    uint32_t changed = 0;
+    for (const FieldMap &f : field_map) {
+        const uint8_t *pa = (const uint8_t *)&a + f.offset;
+        const uint8_t *pb = (const uint8_t *)&b + f.offset;
+        bool same = (f.type == FT_STR) ? strcmp((const char *)pa, (const char *)pb) == 0
+                                       : memcmp(pa, pb, f.size) == 0;
+        if (!same) changed |= f.bit;
+    }
+    return changed;
+}
+
+void WeatherJsonParser::reset()
+{
+    reset_tokenizer();
+    memset(&result, 0, sizeof(result));
+    item_index = -1;
+}
+
+// Inside list[N] of a group response
+bool WeatherJsonParser::in_list_item() const
+{
+    return depth() > ITEM_LEVEL && index_at(1) >= 0 && strcmp(key_at(0), "list") == 0;
+}
+
+// A scalar value is complete, keep it if it is one of ours
+void WeatherJsonParser::on_value(const char *value, bool)
+{
+    int from = 0;
+    if (on_item) {
+        if (!in_list_item()) return;
+        from = ITEM_LEVEL;
+        item_index = index_at(1);
+    }
+
+    for (const FieldMap &f : field_map) {
+        if (!path_is(f.path, from)) continue;
+
+        uint8_t *dst = (uint8_t *)&result + f.offset;
+        switch (f.type) {
+            case FT_STR:
+                strncpy((char *)dst, value, f.size - 1);
+                ((char *)dst)[f.size - 1] = '\0';
+                break;
+            case FT_FLOAT:
+                *(float *)dst = strtof(value, NULL);
+                break;
+            case FT_INT:
+                *(int32_t *)dst = (int32_t)strtol(value, NULL, 10);
+                break;
+            case FT_INT64:
+                *(int64_t *)dst = strtoll(value, NULL, 10);
+                break;
+        }
+        result.fields |= f.bit;
+        break;
+    }
+}
+
+// list[N] ended - deliver it and start the next one from scratch
+void WeatherJsonParser::on_close()
+{
+    if (on_item == NULL || depth() != ITEM_LEVEL + 1 || item_index < 0) return;
+    if (index_at(1) < 0 || strcmp(key_at(0), "list") != 0) return;
+
+    if ((result.fields & WF_REQUIRED) == WF_REQUIRED) on_item(item_index, result, item_ctx);
+    memset(&result, 0, sizeof(result));
+    item_index = -1;
+}
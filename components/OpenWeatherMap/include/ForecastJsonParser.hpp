@@ -0,0 +1,81 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Streaming parser for the OpenWeatherMap 5 day / 3 hour "forecast"
+    response. Every list entry is reduced to a 12 byte ForecastPoint and
+    handed to a callback as soon as it closes, so the ~16KB body never
+    needs to be in memory. Does not depend on ESP-IDF.
+*/
+
+#ifndef TUX_FORECAST_JSON_PARSER_H_
+#define TUX_FORECAST_JSON_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "JsonStreamParser.hpp"
+
+// One 3 hour step
+struct ForecastPoint {
+    uint32_t dt;            // UTC seconds
+    int16_t temp;           // 1/10 degree, in the requested units
+    int16_t temp_min;
+    int16_t temp_max;
+    uint8_t humidity;       // %
+    uint8_t pop;            // probability of precipitation %
+    char icon[4];           // "10d"
+};
+
+class ForecastJsonParser : public JsonStreamParser
+{
+    public:
+        typedef void (*point_cb_t)(const ForecastPoint &point, void *ctx);
+
+        ForecastJsonParser() : on_point(NULL), point_ctx(NULL) { reset(); }
+
+        void reset();
+        void set_handler(point_cb_t cb, void *ctx) { on_point = cb; point_ctx = ctx; }
+
+        bool complete() const { return done() && points > 0; }
+        int count() const { return points; }
+        int32_t city_id() const { return id; }
+        int32_t timezone() const { return tz; }
+
+    protected:
+        void on_value(const char *value, bool is_string) override;
+        void on_close() override;
+
+    private:
+        point_cb_t on_point;
+        void *point_ctx;
+        ForecastPoint point;
+        bool has_dt;
+        int points;
+        int32_t id;
+        int32_t tz;
+
+        bool in_list_item() const;
+};
+
+#endif // TUX_FORECAST_JSON_PARSER_H_
@@ -0,0 +1,100 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Byte-at-a-time JSON tokenizer for HTTP bodies that arrive in chunks.
+    Keeps only the current key path and the scalar being read - no heap,
+    no DOM. Subclasses pick the values they want in on_value() by path
+    and get on_close() for every object/array that ends.
+    Does not depend on ESP-IDF.
+*/
+
+#ifndef TUX_JSON_STREAM_PARSER_H_
+#define TUX_JSON_STREAM_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+class JsonStreamParser
+{
+    public:
+        virtual ~JsonStreamParser() {}
+
+        /* Parse the next chunk, returns false once the input is not valid JSON */
+        bool feed(const char *chunk, size_t len);
+
+        /* Top level value closed */
+        bool done() const { return state == DONE; }
+        bool failed() const { return state == ERROR; }
+        size_t bytes() const { return total_bytes; }
+
+    protected:
+        static constexpr int MAX_DEPTH = 6;         // levels with key path tracking
+        static constexpr int MAX_NESTING = 32;      // levels accepted at all
+        static constexpr int KEY_LEN = 24;
+        static constexpr int VALUE_LEN = 64;
+
+        /* Start a new document */
+        void reset_tokenizer();
+
+        /* A scalar is complete, current path via path_is() */
+        virtual void on_value(const char *value, bool is_string) = 0;
+
+        /* Container at level depth()-1 is about to close */
+        virtual void on_close() {}
+
+        /* Current path from level 'from' on equals a dotted path like "weather.0.icon" */
+        bool path_is(const char *path, int from = 0) const;
+
+        int depth() const { return level; }
+        const char *key_at(int d) const { return (d < level && d < MAX_DEPTH && !frames[d].array) ? frames[d].key : ""; }
+        int index_at(int d) const { return (d < level && d < MAX_DEPTH && frames[d].array) ? frames[d].index : -1; }
+
+    private:
+        enum State : uint8_t { VALUE, KEY_OR_END, KEY, COLON, STRING, LITERAL, AFTER_VALUE, DONE, ERROR };
+
+        struct Frame {
+            bool array;
+            uint16_t index;             // array element
+            char key[KEY_LEN];          // object member being parsed
+        };
+
+        State state;
+        int level;                      // may exceed MAX_DEPTH, deeper frames are not tracked
+        uint32_t array_mask;            // bit per level - container is an array
+        Frame frames[MAX_DEPTH];
+        char value[VALUE_LEN];
+        int value_len;
+        bool escape;
+        uint8_t unicode_left;           // hex digits of \uXXXX still to skip
+        size_t total_bytes;
+
+        bool step(char c);
+        bool push(bool array);
+        void pop();
+        void append(char *buf, int &len, int max, char c);
+        void emit(bool is_string);
+};
+
+#endif // TUX_JSON_STREAM_PARSER_H_
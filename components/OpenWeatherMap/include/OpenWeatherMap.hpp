@@ -78,17 +78,35 @@ SOFTWARE.
 #include <fstream>
 #include <filesystem>
 #include <inttypes.h>
+#include <time.h>
 
 #include "esp_log.h"
 #include <fstream>
 #include "esp_http_client.h"
-#include <cJSON.h>
 using namespace std;
 #include "SettingsConfig.hpp"
+#include "WeatherJsonParser.hpp"
+#include "WeatherCache.hpp"
+#include "HttpPool.hpp"
+
+// Per endpoint memory of the last answer, for conditional requests and change detection
+struct WeatherFetchState {
+    HttpValidators validators;  // ETag / Last-Modified of the last 200
+    uint32_t body_hash;         // FNV-1a of the last 200 body
+    bool not_modified;          // last fetch: 304 or the same body again
+};
+
+struct WeatherRefreshStats {
+    uint32_t not_modified;      // 304 answers
+    uint32_t same_body;         // 200 with a body identical to the last one
+    uint32_t unchanged;         // new body, but none of our fields changed
+    uint32_t writes_skipped;    // cache record not rewritten
+};
 
 class OpenWeatherMap
 {
     public:
+        string Location;        // query - "city,country"
         string LocationName;
         float Temperature;     // 19.8
         float TemperatureHigh;
@@ -101,38 +119,57 @@ class OpenWeatherMap
 
         char TemperatureUnit;   // '' / 'F' / 'C'
         string WeatherIcon;
+        time_t UpdatedAt;       // when the shown values were fetched, 0 if unknown
+
+        /* Constructor - location query, binary cache record, optional seed json */
+        OpenWeatherMap(const string &location = CONFIG_WEATHER_LOCATION,
+                       const string &cache_file = "/spiffs/weather/weather.bin",
+                       const string &seed_json = "/spiffs/weather/weather.json");
+
+        /* HTTPS request to the Weather API, false if the cached values are kept */
+        bool request_weather_update();
+
+        /* New values from a single or group response - applied, diffed and cached */
+        uint32_t update(const WeatherData &data);
+
+        /* WeatherField bits changed since the last call, for partial redraws */
+        uint32_t take_changed() { return __atomic_exchange_n(&changed, 0, __ATOMIC_ACQ_REL); }
+
+        const WeatherData &data() const { return current; }
+
+        /* "/data/2.5/<endpoint>?<params>&units=..&APPID=.." */
+        static string api_path(const char *endpoint, const string &params);
 
-        /* Constructor */
-        OpenWeatherMap();
+        /* GET api_path() and stream the body through parser, ESP_OK on HTTP 200 or 304.
+           With state the request is conditional, state->not_modified says if anything is new */
+        static esp_err_t fetch(const string &path, JsonStreamParser &parser, WeatherFetchState *state = NULL);
 
-        /* HTTPS request to the Weather API */
-        void request_weather_update();
+        static const WeatherRefreshStats &refresh_stats();
 
-        /* Handle json response */
+        /* Refreshes run on a worker task while the UI reads the public fields,
+           new values are applied with this lock held (LVGL lock in main) */
+        static void set_apply_lock(void (*lock)(void), void (*unlock)(void));
 
     private:
         SettingsConfig *cfg;
         string cfg_filename;  /* Settings config filename*/
 
-        string file_name; /* Weather cache filename */
-        string jsonString;
+        string file_name; /* Weather cache filename - binary record */
+        string json_name; /* Seed json shipped in the flash image */
 
-        cJSON *root;
-        cJSON *maininfo;
-        cJSON *coord;
-        cJSON *weather;
-        cJSON *clouds;
-        cJSON *wind;
-        cJSON *sys;
+        WeatherJsonParser parser;   /* Parses the body while it is downloaded */
+        WeatherFetchState fetch_state;
+        WeatherData current;        /* Last applied values */
+        uint32_t changed;           /* WeatherField bits not yet redrawn */
 
-        /* Load data from cache file to the instance */
-        void load_json();
+        /* Copy parsed values to the instance */
+        void apply(const WeatherData &data);
 
-        /* Read cache json from flash/sdcard */
-        void read_json();
+        /* Load the binary cache record, falls back to the seed json */
+        bool load_cache();
 
-        /* Write cache json on flash/sdcard */
-        void write_json();
+        /* Parse seed json from flash/sdcard */
+        bool read_json();
 
         esp_err_t request_json_over_http();        
         esp_err_t request_json_over_https();
@@ -0,0 +1,72 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Binary weather cache - the decoded WeatherData stored as one fixed
+    layout record, so a cold boot reads ~200 bytes straight into the struct
+    instead of parsing the JSON response again.
+
+    [ header: magic | version | size | saved_at | crc32 ] [ WeatherData ]
+
+    Writes go to <path>.tmp (flushed + fsync'd) and are then renamed over the
+    record, so a power cut leaves either the old or the new record, never a
+    torn one. A record failing magic/version/size/crc is ignored.
+*/
+
+#ifndef TUX_WEATHER_CACHE_H_
+#define TUX_WEATHER_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "WeatherJsonParser.hpp"
+
+#define WEATHER_CACHE_MAGIC     0x43575854  // "TXWC"
+#define WEATHER_CACHE_VERSION   2           // bump when WeatherData layout changes
+
+struct WeatherCacheHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;          // sizeof(WeatherData) when written
+    int64_t saved_at;       // time() when written, 0 if clock not set
+    uint32_t crc;           // crc32 of the WeatherData payload
+    uint32_t reserved;
+};
+
+struct WeatherCacheStats {
+    uint32_t writes;
+    uint32_t bytes_written;
+    uint32_t loads;
+    uint32_t load_failures;
+};
+
+/* Atomically replace the record at path. Returns bytes written, 0 on failure */
+size_t weather_cache_save(const char *path, const WeatherData &data);
+
+/* Load and validate the record, saved_at is optional */
+bool weather_cache_load(const char *path, WeatherData *data, int64_t *saved_at);
+
+/* Counters since boot */
+const WeatherCacheStats &weather_cache_stats();
+
+#endif
@@ -0,0 +1,145 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Weather for several locations: current conditions plus hourly (3 hour
+    steps) and daily forecast series kept in fixed ring buffers.
+
+    poll() is called periodically and does at most one request when
+    something is due. Refreshes are staggered across the interval, the
+    current conditions of all known cities go out as one "group" request,
+    and a token bucket keeps the request rate under the API limit.
+    Requests are conditional (ETag / Last-Modified, else a body hash) and
+    the interval stretches while the data does not change.
+    Listeners get a mask of what changed so the UI redraws only that.
+*/
+
+#ifndef TUX_WEATHER_ENGINE_H_
+#define TUX_WEATHER_ENGINE_H_
+
+#include <stdint.h>
+#include "OpenWeatherMap.hpp"
+#include "ForecastJsonParser.hpp"
+#include "WeatherRing.hpp"
+
+#define WEATHER_MAX_LOCATIONS   4
+#define WEATHER_HOURLY_POINTS   16      // 48 hours of 3 hour steps
+#define WEATHER_DAILY_POINTS    6
+
+// Change bits next to the WeatherField bits of the current conditions
+#define WEATHER_CHANGED_HOURLY  (1u << 30)
+#define WEATHER_CHANGED_DAILY   (1u << 31)
+
+// One local calendar day
+struct DailyPoint {
+    uint32_t dt;            // UTC seconds of local midnight
+    int16_t temp_min;       // 1/10 degree
+    int16_t temp_max;
+    uint8_t pop;            // highest probability of precipitation %
+    char icon[4];           // icon of the step closest to noon
+    uint8_t reserved[3];    // no implicit padding, entries are compared with memcmp
+};
+
+struct WeatherLocation {
+    OpenWeatherMap *current;
+    WeatherRing<ForecastPoint, WEATHER_HOURLY_POINTS> hourly;
+    WeatherRing<DailyPoint, WEATHER_DAILY_POINTS> daily;
+    int64_t next_current_us;
+    int64_t next_forecast_us;
+    WeatherFetchState forecast_state;
+    uint8_t failures;
+    uint8_t stable_current;     // refreshes in a row without a change, stretches the interval
+    uint8_t stable_forecast;
+};
+
+struct WeatherEngineStats {
+    uint32_t requests;
+    uint32_t group_requests;        // each one replaces N single requests
+    uint32_t batched;               // locations refreshed by group requests
+    uint32_t forecast_requests;
+    uint32_t failures;
+    uint32_t throttled;             // polls that had work but no token
+    uint32_t updates_unchanged;     // refresh returned the same values - no redraw
+};
+
+class WeatherEngine
+{
+    public:
+        typedef void (*listener_t)(int location, uint32_t changed, void *ctx);
+
+        /* CONFIG_WEATHER_LOCATION first, then CONFIG_WEATHER_EXTRA_LOCATIONS */
+        WeatherEngine();
+
+        int count() const { return locations; }
+        OpenWeatherMap *current(int i) { return loc[i].current; }
+        const WeatherLocation &location(int i) const { return loc[i]; }
+
+        void set_listener(listener_t cb, void *ctx) { listener = cb; listener_ctx = ctx; }
+
+        /* Do at most one due request, returns ms until the next one is due */
+        uint32_t poll();
+
+        const WeatherEngineStats &stats() const { return engine_stats; }
+        void report();
+
+    private:
+        WeatherLocation loc[WEATHER_MAX_LOCATIONS];
+        int locations;
+        listener_t listener;
+        void *listener_ctx;
+
+        float tokens;               // token bucket for the API rate limit
+        int64_t tokens_at_us;
+        uint8_t group_failures;
+        uint32_t group_seen;        // location bits found in the group response
+        uint32_t group_changed;     // ... and with new values
+        WeatherFetchState group_state;
+
+        WeatherJsonParser group_parser;
+        ForecastJsonParser forecast_parser;
+        WeatherEngineStats engine_stats;
+
+        // Forecast being parsed
+        int fc_loc;
+        int32_t fc_tz;
+        uint32_t fc_first_dt;
+        uint32_t fc_changed;
+        DailyPoint fc_day;
+        int fc_day_noon_dist;
+
+        bool take_token(int64_t now);
+        int due_group(int64_t now, int64_t window);
+        bool refresh_group(int64_t now);
+        bool refresh_current(int i, int64_t now);
+        bool refresh_forecast(int i, int64_t now);
+        void finished(int i, bool ok, bool changed, int64_t *next, uint8_t *stable,
+                      int64_t interval_us, int64_t now);
+        void notify(int i, uint32_t changed);
+        void flush_day();
+
+        static void on_group_item(int index, const WeatherData &data, void *ctx);
+        static void on_forecast_point(const ForecastPoint &point, void *ctx);
+};
+
+#endif // TUX_WEATHER_ENGINE_H_
@@ -0,0 +1,129 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Streaming parser for the OpenWeatherMap "current weather" response.
+    Feed it the HTTP body chunk by chunk as it arrives (any chunk size, any
+    body size) - it keeps only the current key path and the scalar being
+    read, picks the handful of fields we show and drops everything else.
+    No heap, no DOM, no copy of the body. Does not depend on ESP-IDF.
+
+    In list mode it reads the "group" response instead - the same record
+    for several cities in "list" - and hands each one to a callback.
+*/
+
+#ifndef TUX_WEATHER_JSON_PARSER_H_
+#define TUX_WEATHER_JSON_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "JsonStreamParser.hpp"
+
+// Fields picked from the response, bit per field in WeatherData::fields
+enum WeatherField : uint32_t {
+    WF_NAME         = 1 << 0,
+    WF_TEMP         = 1 << 1,
+    WF_FEELS_LIKE   = 1 << 2,
+    WF_TEMP_MIN     = 1 << 3,
+    WF_TEMP_MAX     = 1 << 4,
+    WF_PRESSURE     = 1 << 5,
+    WF_HUMIDITY     = 1 << 6,
+    WF_SEA_LEVEL    = 1 << 7,
+    WF_GRND_LEVEL   = 1 << 8,
+    WF_VISIBILITY   = 1 << 9,
+    WF_MAIN         = 1 << 10,
+    WF_DESCRIPTION  = 1 << 11,
+    WF_ICON         = 1 << 12,
+    WF_LON          = 1 << 13,
+    WF_LAT          = 1 << 14,
+    WF_WIND_SPEED   = 1 << 15,
+    WF_WIND_DEG     = 1 << 16,
+    WF_DT           = 1 << 17,
+    WF_COD          = 1 << 18,
+    WF_ID           = 1 << 19,
+    WF_TIMEZONE     = 1 << 20,
+};
+
+// Minimum set for a usable update
+static constexpr uint32_t WF_REQUIRED = WF_NAME | WF_TEMP | WF_TEMP_MIN | WF_TEMP_MAX | WF_ICON;
+
+struct WeatherData {
+    char name[32];
+    char main[24];
+    char description[48];
+    char icon[8];
+    float temp;
+    float feels_like;
+    float temp_min;
+    float temp_max;
+    int32_t pressure;
+    int32_t humidity;
+    int32_t sea_level;
+    int32_t grnd_level;
+    int32_t visibility;
+    float lon;
+    float lat;
+    float wind_speed;
+    int32_t wind_deg;
+    int64_t dt;
+    int32_t cod;
+    int32_t id;             // city id, used for group requests
+    int32_t timezone;       // seconds from UTC
+    uint32_t fields;        // WeatherField bits found in the document
+};
+
+/* WeatherField bits whose values differ between a and b */
+uint32_t weather_data_diff(const WeatherData &a, const WeatherData &b);
+
+class WeatherJsonParser : public JsonStreamParser
+{
+    public:
+        typedef void (*item_cb_t)(int index, const WeatherData &data, void *ctx);
+
+        WeatherJsonParser() : on_item(NULL), item_ctx(NULL) { reset(); }
+
+        /* Start a new document */
+        void reset();
+
+        /* Parse a group response, every list entry goes to cb. NULL for a single response */
+        void set_list_handler(item_cb_t cb, void *ctx) { on_item = cb; item_ctx = ctx; }
+
+        bool complete() const { return done() && (result.fields & WF_REQUIRED) == WF_REQUIRED; }
+
+        const WeatherData &data() const { return result; }
+
+    protected:
+        void on_value(const char *value, bool is_string) override;
+        void on_close() override;
+
+    private:
+        WeatherData result;
+        item_cb_t on_item;
+        void *item_ctx;
+        int item_index;
+
+        bool in_list_item() const;
+};
+
+#endif // TUX_WEATHER_JSON_PARSER_H_
@@ -0,0 +1,98 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Fixed capacity time series - oldest entries fall off the front as new
+    ones are appended. Entries are keyed by their 'dt' member: a refresh
+    that repeats a timestamp overwrites it in place, so re-fetching the
+    forecast updates the series instead of growing it.
+*/
+
+#ifndef TUX_WEATHER_RING_H_
+#define TUX_WEATHER_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+template <typename T, size_t N>
+class WeatherRing
+{
+    public:
+        WeatherRing() { clear(); }
+
+        void clear() { head = 0; len = 0; }
+        size_t size() const { return len; }
+        static constexpr size_t capacity() { return N; }
+        bool empty() const { return len == 0; }
+
+        /* i = 0 is the oldest entry */
+        const T &operator[](size_t i) const { return items[(head + i) % N]; }
+        const T &back() const { return (*this)[len - 1]; }
+
+        /* Insert or overwrite by dt, returns true if the series changed */
+        bool put(const T &item)
+        {
+            if (len && item.dt <= back().dt) {
+                for (size_t i = len; i-- > 0;) {
+                    T &cur = at(i);
+                    if (cur.dt == item.dt) {
+                        if (memcmp(&cur, &item, sizeof(T)) == 0) return false;
+                        cur = item;
+                        return true;
+                    }
+                    if (cur.dt < item.dt) break;
+                }
+                return false;   // older than what we keep or out of order
+            }
+
+            if (len == N) {
+                head = (head + 1) % N;      // drop the oldest
+                len--;
+            }
+            at(len++) = item;
+            return true;
+        }
+
+        /* Drop entries older than dt, returns how many */
+        size_t prune(uint32_t dt)
+        {
+            size_t dropped = 0;
+            while (len && (*this)[0].dt < dt) {
+                head = (head + 1) % N;
+                len--;
+                dropped++;
+            }
+            return dropped;
+        }
+
+    private:
+        T items[N];
+        size_t head;
+        size_t len;
+
+        T &at(size_t i) { return items[(head + i) % N]; }
+};
+
+#endif // TUX_WEATHER_RING_H_
@@ -23,101 +23,386 @@ SOFTWARE.
 */
 
 #include "SettingsConfig.hpp"
+#include "SettingsFields.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "nvs.h"
+
 static const char* TAG = "SettingsConfig";
 
+static const char *NVS_PREFIX = "nvs:";
+static const char *NVS_KEY = "settings";
+
+template <typename T>
+using Field = SettingField<SettingsValues, T>;
+
+static constexpr auto SETTINGS_FIELDS = std::make_tuple(
+    Field<string>          { SETTING_DEVICE_NAME,       NULL,       "devicename", &SettingsValues::DeviceName,      "MYDEVICE",         1, 32 },
+    Field<uint8_t>         { SETTING_BRIGHTNESS,        "settings", "brightness", &SettingsValues::Brightness,      128,                0, 255 },
+    Field<string>          { SETTING_THEME,             "settings", "theme",      &SettingsValues::CurrentTheme,    "dark",             1, 16 },   // light / theme / ???
+    Field<string>          { SETTING_TIMEZONE,          "settings", "timezone",   &SettingsValues::TimeZone,        "+5:30",            1, 64 },
+    Field<string>          { SETTING_WEATHER_PROVIDER,  "weather",  "provider",   &SettingsValues::WeatherProvider, "OpenWeatherMaps",  0, 128 },
+    Field<string>          { SETTING_WEATHER_LOCATION,  "weather",  "location",   &SettingsValues::WeatherLocation, "Bangalore, India", 0, 128 },
+    Field<string>          { SETTING_WEATHER_API_KEY,   "weather",  "apikey",     &SettingsValues::WeatherAPIkey,   "",                 0, 64 },
+    Field<uint>            { SETTING_WEATHER_INTERVAL,  "weather",  "interval",   &SettingsValues::WeatherUpdateInterval, 5 * 60,       60, 24 * 3600 },   // Every 5mins
+    Field<weather_units_t> { SETTING_TEMPERATURE_UNITS, "weather",  "units",      &SettingsValues::TemperatureUnits, WEATHER_UNITS_CELSIUS, WEATHER_UNITS_KELVIN, WEATHER_UNITS_FAHRENHEIT }
+);
+
+static_assert(settings_bits(SETTINGS_FIELDS) == SETTING_ALL, "Every settings_field_t bit needs exactly one field");
+
+template <typename T>
+static void field_default(const Field<T> &field, SettingsValues &v)
+{
+    v.*field.member = field.def;
+}
+
+static cJSON *field_parent(cJSON *root, const char *section)
+{
+    if (section == NULL) return root;
+    cJSON *obj = cJSON_GetObjectItem(root, section);
+    if (obj == NULL) cJSON_AddItemToObject(root, section, obj = cJSON_CreateObject());
+    return obj;
+}
+
 SettingsConfig::SettingsConfig(string filename)
 {
     // If load is not called, these are the default values
-    DeviceName = "MYDEVICE";
-    Brightness = 128;                       // 0-255
-    TimeZone = "+5:30";           
-    CurrentTheme = "dark";                  // light / theme / ???
+    reset_defaults();
 
-    WeatherProvider = "OpenWeatherMaps";
-    WeatherLocation = "Bangalore, India";
-    WeatherAPIkey = "";
-    WeatherUpdateInterval = 5 * 60;    // Every 5mins
-    TemperatureUnits = WEATHER_UNITS_CELSIUS;
+    if (filename.compare(0, strlen(NVS_PREFIX), NVS_PREFIX) == 0)
+        nvs_namespace = filename.substr(strlen(NVS_PREFIX));
+    else
+        file_name = filename;
 
-    file_name = filename;
+    saved = *this;
+    stored = false;
+    pending = *this;
+    has_pending = false;
+    dispatch = NULL;
+    st = {};
+    notified = *this;
+    listener = NULL;
+    listener_ctx = NULL;
+
+    write_lock = xSemaphoreCreateMutex();
+    pending_lock = xSemaphoreCreateMutex();
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = &SettingsConfig::save_timer_cb,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "settings_save",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &save_timer));
 }
 
 void SettingsConfig::load_config()
 {
-    ESP_LOGD(TAG,"******************* Loading JSON *******************");
+    int64_t start = esp_timer_get_time();
+    string data;
 
-    if (!file_name.empty()) read_json_file();   // read into jsonString
+    xSemaphoreTake(write_lock, portMAX_DELAY);
+    stored = read_store(data) && decode(data, *this);
+    saved = *this;
+    xSemaphoreGive(write_lock);
 
-    // Read json variable and parse to cjson object
-    root = cJSON_Parse(jsonString.c_str());
+    st.load_us = esp_timer_get_time() - start;
+    notify();
+    if (stored) {
+        ESP_LOGI(TAG,"Loaded %u bytes from %s in %" PRIu32 "us", data.size(),
+                    nvs_namespace.empty() ? file_name.c_str() : "nvs", st.load_us);
+        ESP_LOGD(TAG,"Loaded:\n%s", data.c_str());
+    } else {
+        ESP_LOGW(TAG,"No valid settings in %s, using defaults (%" PRIu32 "us)",
+                    nvs_namespace.empty() ? file_name.c_str() : "nvs", st.load_us);
+    }
+}
 
-    // Get root element item
-	settings = cJSON_GetObjectItem(root,"settings");
+bool SettingsConfig::save_config()
+{
+    validate();
+    notify();
 
-	this->Brightness = cJSON_GetObjectItem(settings,"brightness")->valueint;
-    this->CurrentTheme = cJSON_GetObjectItem(settings,"theme")->valuestring;
-    this->TimeZone = cJSON_GetObjectItem(settings,"timezone")->valuestring;
+    // Newer than anything pending
+    esp_timer_stop(save_timer);
+    xSemaphoreTake(pending_lock, portMAX_DELAY);
+    has_pending = false;
+    xSemaphoreGive(pending_lock);
 
-    ESP_LOGD(TAG,"Loaded:\n%s",jsonString.c_str());
+    return write_values(*this);
+}
+
+void SettingsConfig::save_later()
+{
+    validate();
+    notify();
+
+    xSemaphoreTake(pending_lock, portMAX_DELAY);
+    st.requests++;
+    if (has_pending) st.coalesced++;
+    pending = *this;
+    has_pending = true;
+    xSemaphoreGive(pending_lock);
+
+    // Restart the window on every change - a slider drag ends up as one write
+    esp_timer_stop(save_timer);
+    esp_timer_start_once(save_timer, CONFIG_TUX_SETTINGS_DEBOUNCE_MS * 1000ULL);
+}
+
+void SettingsConfig::flush()
+{
+    esp_timer_stop(save_timer);
+    save_job(this);
+}
+
+uint32_t SettingsConfig::dirty()
+{
+    xSemaphoreTake(write_lock, portMAX_DELAY);
+    uint32_t bits = stored ? diff(saved, *this) : SETTING_ALL;
+    xSemaphoreGive(write_lock);
+    return bits;
+}
+
+uint32_t SettingsConfig::validate()
+{
+    uint32_t bits = 0;
+    settings_for_each(SETTINGS_FIELDS, [&](const auto &field) {
+        using T = std::remove_cv_t<std::remove_reference_t<decltype(this->*field.member)>>;
+        if (SettingCodec<T>::valid(this->*field.member, field.min, field.max)) return;
+        ESP_LOGW(TAG,"%s out of range, default used", field.key);
+        field_default(field, *this);
+        bits |= field.bit;
+        st.invalid++;
+    });
+    return bits;
+}
+
+void SettingsConfig::reset_defaults()
+{
+    settings_for_each(SETTINGS_FIELDS, [&](const auto &field) {
+        field_default(field, *this);
+    });
+}
+
+void SettingsConfig::set_dispatcher(settings_dispatch_t dispatch)
+{
+    this->dispatch = dispatch;
+}
+
+void SettingsConfig::set_listener(settings_listener_t listener, void *ctx)
+{
+    this->listener_ctx = ctx;
+    this->listener = listener;
+}
+
+void SettingsConfig::notify()
+{
+    uint32_t bits = diff(notified, *this);
+    if (bits == 0) return;
+    notified = *this;
+    if (listener) listener(bits, listener_ctx);
+}
 
-    // Cleanup
+void SettingsConfig::report() const
+{
+    ESP_LOGI(TAG,"settings writes:%" PRIu32 " (%" PRIu32 " bytes, %" PRIu32 " failed) skipped:%" PRIu32
+                 " requests:%" PRIu32 " coalesced:%" PRIu32 " invalid:%" PRIu32 " write max:%" PRIu32 "us load:%" PRIu32 "us",
+                st.writes, st.bytes_written, st.write_failures, st.writes_skipped,
+                st.requests, st.coalesced, st.invalid, st.write_us_max, st.load_us);
+}
+
+void SettingsConfig::save_timer_cb(void *arg)
+{
+    SettingsConfig *cfg = (SettingsConfig *)arg;
+    // Flash writes may stall for a while, keep them off the esp_timer task when possible
+    if (cfg->dispatch) cfg->dispatch(&SettingsConfig::save_job, cfg);
+    else save_job(cfg);
+}
+
+void SettingsConfig::save_job(void *arg)
+{
+    SettingsConfig *cfg = (SettingsConfig *)arg;
+
+    xSemaphoreTake(cfg->pending_lock, portMAX_DELAY);
+    if (!cfg->has_pending) {
+        xSemaphoreGive(cfg->pending_lock);
+        return;
+    }
+    SettingsValues values = cfg->pending;
+    cfg->has_pending = false;
+    xSemaphoreGive(cfg->pending_lock);
+
+    cfg->write_values(values);
+}
+
+uint32_t SettingsConfig::diff(const SettingsValues &a, const SettingsValues &b) const
+{
+    uint32_t bits = 0;
+    settings_for_each(SETTINGS_FIELDS, [&](const auto &field) {
+        if (!(a.*field.member == b.*field.member)) bits |= field.bit;
+    });
+    return bits;
+}
+
+bool SettingsConfig::write_values(const SettingsValues &v)
+{
+    xSemaphoreTake(write_lock, portMAX_DELAY);
+
+    uint32_t bits = stored ? diff(saved, v) : SETTING_ALL;
+    if (bits == 0) {
+        st.writes_skipped++;
+        xSemaphoreGive(write_lock);
+        ESP_LOGD(TAG,"Nothing changed, write skipped");
+        return false;
+    }
+
+    int64_t start = esp_timer_get_time();
+    string data = encode(v);
+    bool ok = write_store(data);
+    uint32_t elapsed = esp_timer_get_time() - start;
+
+    if (ok) {
+        saved = v;
+        stored = true;
+        st.writes++;
+        st.bytes_written += data.size();
+        if (elapsed > st.write_us_max) st.write_us_max = elapsed;
+    } else {
+        st.write_failures++;
+    }
+    xSemaphoreGive(write_lock);
+
+    if (ok) {
+        ESP_LOGI(TAG,"Saved %u bytes (dirty 0x%02" PRIx32 ") in %" PRIu32 "us - %" PRIu32 " writes since boot",
+                    data.size(), bits, elapsed, st.writes);
+        ESP_LOGD(TAG,"Saved:\n%s", data.c_str());
+    }
+    return ok;
+}
+
+string SettingsConfig::encode(const SettingsValues &v) const
+{
+    cJSON *root = cJSON_CreateObject();
+    settings_for_each(SETTINGS_FIELDS, [&](const auto &field) {
+        using T = std::remove_cv_t<std::remove_reference_t<decltype(v.*field.member)>>;
+        SettingCodec<T>::write(field_parent(root, field.section), field.key, v.*field.member);
+    });
+
+    // No indentation - about half the bytes on flash
+    char *json = cJSON_PrintUnformatted(root);
+    string data = json ? json : "";
+    cJSON_free(json);
     cJSON_Delete(root);
+    return data;
 }
 
-void SettingsConfig::save_config()
-{    
-    ESP_LOGD(TAG,"******************* Saving JSON *******************");
-    // Create json object
-	root=cJSON_CreateObject();
-    
-    // set root string elements
-	cJSON_AddItemToObject(root, "devicename", cJSON_CreateString(this->DeviceName.c_str()));
-    
-    // create settings object on root
-    cJSON_AddItemToObject(root, "settings", settings=cJSON_CreateObject());
-
-    // Create elements
-	cJSON_AddNumberToObject(settings,"brightness",this->Brightness);
-	cJSON_AddStringToObject(settings,"theme",this->CurrentTheme.c_str());
-	cJSON_AddStringToObject (settings,"timezone",this->TimeZone.c_str());
-
-    // Save json string to variable
-    jsonString = cJSON_Print(root);   // back to string
-    
-    // Cleanup
+bool SettingsConfig::decode(const string &json, SettingsValues &v)
+{
+    cJSON *root = cJSON_Parse(json.c_str());
+    if (!cJSON_IsObject(root)) {
+        ESP_LOGE(TAG,"Settings parse failed");
+        cJSON_Delete(root);
+        return false;
+    }
+
+    // Missing fields keep what's there, mistyped or out of range ones too
+    settings_for_each(SETTINGS_FIELDS, [&](const auto &field) {
+        using T = std::remove_cv_t<std::remove_reference_t<decltype(v.*field.member)>>;
+        cJSON *parent = field.section ? cJSON_GetObjectItem(root, field.section) : root;
+        cJSON *item = cJSON_GetObjectItem(parent, field.key);
+        if (item == NULL) return;
+        if (!SettingCodec<T>::read(item, v.*field.member, field.min, field.max)) {
+            ESP_LOGW(TAG,"Stored %s is invalid, ignored", field.key);
+            st.invalid++;
+        }
+    });
+
     cJSON_Delete(root);
+    return true;
+}
 
-    ESP_LOGD(TAG,"Saved:\n%s",jsonString.c_str());
+bool SettingsConfig::read_file(const string &path, string &data)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == NULL) return false;
 
-    // Save jsonString to peristant storage
-    if (!file_name.empty()) write_json_file();
+    char buf[128];
+    size_t n;
+    data.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+    fclose(f);
+    return !data.empty();
 }
 
-void SettingsConfig::read_json_file()
+bool SettingsConfig::read_store(string &data)
 {
-    // read json file to string    
-    ifstream jsonfile(file_name);
-    if (!jsonfile.is_open())
-    {
-        ESP_LOGE(TAG,"File open for read failed %s",file_name.c_str());
-        save_config();  // create file with default values
+    if (!nvs_namespace.empty()) {
+        nvs_handle_t handle;
+        if (nvs_open(nvs_namespace.c_str(), NVS_READONLY, &handle) != ESP_OK) return false;
+
+        size_t len = 0;
+        esp_err_t err = nvs_get_str(handle, NVS_KEY, NULL, &len);
+        if (err == ESP_OK && len > 1) {
+            data.resize(len);
+            err = nvs_get_str(handle, NVS_KEY, &data[0], &len);
+            data.resize(len - 1);   // terminator
+        }
+        nvs_close(handle);
+        return err == ESP_OK && !data.empty();
     }
 
-    jsonString.assign((std::istreambuf_iterator<char>(jsonfile)),
-                (std::istreambuf_iterator<char>()));
+    if (read_file(file_name, data)) return true;
 
-    jsonfile.close();
+    // Power cut between unlink and rename - the complete .tmp is the latest
+    string tmp_name = file_name + ".tmp";
+    if (read_file(tmp_name, data)) {
+        ESP_LOGW(TAG,"Recovered settings from %s", tmp_name.c_str());
+        unlink(file_name.c_str());
+        rename(tmp_name.c_str(), file_name.c_str());
+        return true;
+    }
+    return false;
 }
 
-void SettingsConfig::write_json_file()
+bool SettingsConfig::write_store(const string &data)
 {
-    ofstream jsonfile(file_name);
-    if (!jsonfile.is_open())
-    {
-        ESP_LOGE(TAG,"File open for write failed %s",file_name.c_str());
-        return ;//ESP_FAIL;
+    if (!nvs_namespace.empty()) {
+        // NVS keeps the old entry until the new one is complete and spreads wear itself
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(nvs_namespace.c_str(), NVS_READWRITE, &handle);
+        if (err == ESP_OK) {
+            err = nvs_set_str(handle, NVS_KEY, data.c_str());
+            if (err == ESP_OK) err = nvs_commit(handle);
+            nvs_close(handle);
+        }
+        if (err != ESP_OK) ESP_LOGE(TAG,"NVS write failed: %s", esp_err_to_name(err));
+        return err == ESP_OK;
+    }
+
+    string tmp_name = file_name + ".tmp";
+    FILE *f = fopen(tmp_name.c_str(), "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG,"File open for write failed %s", tmp_name.c_str());
+        return false;
+    }
+
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size()
+           && fflush(f) == 0
+           && fsync(fileno(f)) == 0;
+    fclose(f);
+
+    if (!ok) {
+        ESP_LOGE(TAG,"File write failed %s", tmp_name.c_str());
+        unlink(tmp_name.c_str());
+        return false;
+    }
+
+    unlink(file_name.c_str());  // SPIFFS rename doesn't replace, read_store() recovers the .tmp
+    if (rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+        ESP_LOGE(TAG,"File rename failed %s", file_name.c_str());
+        return false;
     }
-    jsonfile << jsonString;
-    jsonfile.flush();
-    jsonfile.close();
+    return true;
 }
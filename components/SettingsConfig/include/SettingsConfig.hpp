@@ -23,28 +23,41 @@ SOFTWARE.
 */
 
 /*
-Config Json format:
+Config Json format (stored unformatted):
 {
     "devicename": "yow",
     "settings": {
         "brightness":128,       // 0-255
         "theme":"dark",         // dark/light ???
         "timezone":"+5:30",     // IST
+    },
+    "weather": {
+        "provider":"OpenWeatherMaps",
+        "location":"Bangalore, India",
+        "apikey":"",
+        "interval":300,         // seconds
+        "units":1               // weather_units_t
     }
 }
+
+Fields, defaults and valid ranges are listed once in SettingsConfig.cpp
+(SETTINGS_FIELDS), see SettingsFields.hpp.
+
+Storage is a file ("/spiffs/settings.json") or NVS ("nvs:<namespace>").
+Only persisted fields that differ from what storage holds make a write,
+save_later() folds changes within CONFIG_TUX_SETTINGS_DEBOUNCE_MS into one.
 */
 
 #ifndef TUX_SETTINGSCONFIG_H_
 #define TUX_SETTINGSCONFIG_H_
 
-#include <iostream>
-#include <sstream>
-#include <fstream>
-#include <filesystem>
+#include <string>
 #include <inttypes.h>
 #include <esp_log.h>
-#include <fstream>
+#include <esp_timer.h>
 #include <cJSON.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 using namespace std;
 
@@ -60,33 +73,115 @@ typedef enum{
     UNITS_IMPERIAL
 } measurement_units_t;
 
-class SettingsConfig
+/* Persisted fields - dirty / change bits */
+typedef enum {
+    SETTING_DEVICE_NAME         = 1 << 0,
+    SETTING_BRIGHTNESS          = 1 << 1,
+    SETTING_THEME               = 1 << 2,
+    SETTING_TIMEZONE            = 1 << 3,
+    SETTING_WEATHER_PROVIDER    = 1 << 4,
+    SETTING_WEATHER_LOCATION    = 1 << 5,
+    SETTING_WEATHER_API_KEY     = 1 << 6,
+    SETTING_WEATHER_INTERVAL    = 1 << 7,
+    SETTING_TEMPERATURE_UNITS   = 1 << 8,
+    SETTING_ALL                 = (1 << 9) - 1
+} settings_field_t;
+
+struct SettingsValues
+{
+    string DeviceName;
+    uint8_t Brightness;        // 0-255
+    string TimeZone;           // +5:30
+    string CurrentTheme;       // dark / light
+
+    string WeatherProvider;     // OpenWeatherMap
+    string WeatherLocation;            // Bangalore, India
+    string WeatherAPIkey;              // "ABCD..."
+    uint WeatherUpdateInterval;        // in seconds
+    weather_units_t TemperatureUnits;
+};
+
+typedef struct {
+    uint32_t writes;
+    uint32_t bytes_written;
+    uint32_t write_failures;
+    uint32_t writes_skipped;    // save with nothing dirty
+    uint32_t requests;          // save_later() calls
+    uint32_t coalesced;         // folded into an already pending save
+    uint32_t write_us_max;
+    uint32_t load_us;           // last load_config()
+    uint32_t invalid;           // stored or assigned values outside the schema, defaults used
+} SettingsStats;
+
+/* Runs a save job elsewhere (a worker task), inline on the esp_timer task if not set */
+typedef void (*settings_dispatch_t)(void (*job)(void *arg), void *arg);
+
+/* Called on the task that loaded or changed the settings, with settings_field_t bits */
+typedef void (*settings_listener_t)(uint32_t changed, void *ctx);
+
+class SettingsConfig : public SettingsValues
 {
     public:
-        string DeviceName;
-        uint8_t Brightness;        // 0-255
-        string TimeZone;           // +5:30
-        string CurrentTheme;       // dark / light
-
-        string WeatherProvider;     // OpenWeatherMap
-        string WeatherLocation;            // Bangalore, India
-        string WeatherAPIkey;              // "ABCD..."
-        uint WeatherUpdateInterval;        // in seconds
-        weather_units_t TemperatureUnits;
-
-        //SettingsConfig();
         SettingsConfig(string filename);
+
         void load_config();
-        void save_config();
 
-    private:
-        void read_json_file();
-        void write_json_file();
+        /* Write now if anything persisted changed, true if written */
+        bool save_config();
+
+        /* Write after CONFIG_TUX_SETTINGS_DEBOUNCE_MS without further changes,
+           values are captured on the calling task */
+        void save_later();
+
+        /* Write a pending save_later() right away */
+        void flush();
+
+        /* Persisted fields that differ from storage */
+        uint32_t dirty();
+
+        /* Put fields outside the schema back to their defaults, returns their bits */
+        uint32_t validate();
 
+        void reset_defaults();
+
+        void set_dispatcher(settings_dispatch_t dispatch);
+        void set_listener(settings_listener_t listener, void *ctx);
+
+        const SettingsStats &stats() const { return st; }
+        void report() const;
+
+    private:
         string file_name;
-        string jsonString;
-        cJSON *root;
-        cJSON *settings;
+        string nvs_namespace;           /* Set for "nvs:<namespace>" */
+
+        SettingsValues saved;           /* What storage holds */
+        bool stored;                    /* Storage had a valid record */
+        SemaphoreHandle_t write_lock;
+
+        SettingsValues pending;         /* Captured by save_later() */
+        bool has_pending;
+        SemaphoreHandle_t pending_lock;
+
+        esp_timer_handle_t save_timer;
+        settings_dispatch_t dispatch;
+        SettingsStats st;
+
+        SettingsValues notified;        /* Values the listener last heard about */
+        settings_listener_t listener;
+        void *listener_ctx;
+        void notify();
+
+        uint32_t diff(const SettingsValues &a, const SettingsValues &b) const;
+        string encode(const SettingsValues &v) const;
+        bool decode(const string &json, SettingsValues &v);
+        bool write_values(const SettingsValues &v);
+
+        bool read_store(string &data);
+        bool write_store(const string &data);
+        bool read_file(const string &path, string &data);
+
+        static void save_timer_cb(void *arg);
+        static void save_job(void *arg);
     protected:
 };
 
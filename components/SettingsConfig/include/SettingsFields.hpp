@@ -0,0 +1,126 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Compile time settings schema
+    Each persisted field is described once - json section and key, the
+    SettingsValues member, default and valid range - and load, save,
+    validation, defaults and diffing are generated from the table for
+    every field. Descriptors are constexpr, walking them allocates nothing.
+*/
+
+#ifndef TUX_SETTINGSFIELDS_H_
+#define TUX_SETTINGSFIELDS_H_
+
+#include <string.h>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <cJSON.h>
+
+/* Strings default to a literal, everything else to a value of the field type */
+template <typename T>
+using setting_default_t = std::conditional_t<std::is_same_v<T, std::string>, const char *, T>;
+
+template <typename S, typename T>
+struct SettingField
+{
+    uint32_t bit;                   /* dirty / change bit */
+    const char *section;            /* NULL - top level */
+    const char *key;
+    T S::*member;
+    setting_default_t<T> def;
+    long min;                       /* numbers: value range, strings: length */
+    long max;
+};
+
+template <typename T, typename Enable = void>
+struct SettingCodec;
+
+template <>
+struct SettingCodec<std::string>
+{
+    static bool valid(const std::string &v, long min, long max)
+    {
+        return (long)v.size() >= min && (long)v.size() <= max;
+    }
+
+    static bool read(const cJSON *item, std::string &v, long min, long max)
+    {
+        if (!cJSON_IsString(item) || item->valuestring == NULL) return false;
+        long len = strlen(item->valuestring);
+        if (len < min || len > max) return false;
+        v = item->valuestring;
+        return true;
+    }
+
+    static void write(cJSON *obj, const char *key, const std::string &v)
+    {
+        cJSON_AddStringToObject(obj, key, v.c_str());
+    }
+};
+
+template <typename T>
+struct SettingCodec<T, std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>>
+{
+    static bool valid(const T &v, long min, long max)
+    {
+        return (long)v >= min && (long)v <= max;
+    }
+
+    static bool read(const cJSON *item, T &v, long min, long max)
+    {
+        // Range check before narrowing - 300 must not end up as brightness 44
+        if (!cJSON_IsNumber(item)) return false;
+        double d = item->valuedouble;
+        if (d < min || d > max || d != (long)d) return false;
+        v = (T)(long)d;
+        return true;
+    }
+
+    static void write(cJSON *obj, const char *key, const T &v)
+    {
+        cJSON_AddNumberToObject(obj, key, (double)(long)v);
+    }
+};
+
+template <typename Tuple, typename Fn>
+static inline void settings_for_each(const Tuple &fields, Fn &&fn)
+{
+    std::apply([&](const auto &...field) { (fn(field), ...); }, fields);
+}
+
+/* OR of all bits, zero if two fields share one - for static_assert */
+template <typename Tuple>
+constexpr uint32_t settings_bits(const Tuple &fields)
+{
+    return std::apply([](const auto &...field) {
+        uint32_t all = 0;
+        bool unique = true;
+        ((unique = unique && !(all & field.bit), all |= field.bit), ...);
+        return unique ? all : 0u;
+    }, fields);
+}
+
+#endif
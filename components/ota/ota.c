@@ -17,6 +17,8 @@
 #include "esp_http_client.h"
 #include "esp_https_ota.h"
 #include "ota.h"
+#include "ota_delta.h"
+#include "ota_compressed.h"
 
 #if CONFIG_BOOTLOADER_APP_ANTI_ROLLBACK
 #include "esp_efuse.h"
@@ -82,6 +84,27 @@ static esp_err_t _http_client_init_cb(esp_http_client_handle_t http_client)
     return err;
 }
 
+// Reboots after a successful delta/compressed update, ends the task when the version was rejected
+static void ota_stream_result(const char *kind, esp_err_t err)
+{
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "OTA upgrade (%s) successful. Rebooting ...", kind);
+
+        strcpy(ota_reason,"Upgrade successful");
+        ESP_ERROR_CHECK(esp_event_post(TUX_EVENTS, TUX_EVENT_OTA_COMPLETED, ota_reason,sizeof(ota_reason), portMAX_DELAY));
+
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        esp_restart();
+    }
+    if (err == ESP_ERR_INVALID_VERSION) {
+        // validate_image_header already reported why
+        vTaskDelete(NULL);
+    }
+    ESP_LOGW(TAG, "%s update not possible (%s), trying the next one", kind, esp_err_to_name(err));
+    strcpy(ota_reason,"Downloading...");
+    ESP_ERROR_CHECK(esp_event_post(TUX_EVENTS, TUX_EVENT_OTA_STARTED, ota_reason,sizeof(ota_reason), portMAX_DELAY));
+}
+
 void run_ota_task(void *pvParameter)
 {
     ESP_LOGI(TAG, "Starting OTA");
@@ -145,6 +168,14 @@ void run_ota_task(void *pvParameter)
     config.skip_cert_common_name_check = true;
 #endif
 
+    // Smallest download first - patch against the running firmware, compressed image, plain image
+#if CONFIG_OTA_DELTA
+    ota_stream_result("delta", ota_delta_run(&config, validate_image_header));
+#endif
+#if CONFIG_OTA_COMPRESSED
+    ota_stream_result("compressed", ota_compressed_run(&config, validate_image_header));
+#endif
+
     esp_https_ota_config_t ota_config = {
         .http_config = &config,
         .http_client_init_cb = _http_client_init_cb, // Register a callback to be invoked after esp_http_client is initialized
@@ -180,33 +211,42 @@ void run_ota_task(void *pvParameter)
         goto ota_end;
     }
 
-    int counter=0;
+    int image_size = esp_https_ota_get_image_size(https_ota_handle);
+    ota_progress_t progress = { .percent = -1, .bytes_read = 0 };
+    int last_kb_step = 0;
     while (1) {
         err = esp_https_ota_perform(https_ota_handle);
         if (err != ESP_ERR_HTTPS_OTA_IN_PROGRESS) {
             break;
         }
 
-        counter++;
         // esp_https_ota_perform returns after every read operation which gives user the ability to
         // monitor the status of OTA upgrade by calling esp_https_ota_get_image_len_read, which gives length of image
         // data read so far.
         int image_len_read = esp_https_ota_get_image_len_read(https_ota_handle);
         ESP_LOGD(TAG, "Image bytes read: %d", image_len_read);
 
-        // One event trigger for every x count
-        if (counter > 200)
-        {
-            /* Too many events generated with this. Maybe trigger event for every 10th item? */
-            // Notify about TUX_EVENT_OTA_IN_PROGRESS event / Calculate and send progress percentage (or bytes)
-            ESP_ERROR_CHECK(esp_event_post(TUX_EVENTS, TUX_EVENT_OTA_IN_PROGRESS, &image_len_read,sizeof(image_len_read), portMAX_DELAY));        
-            counter = 0; //reset
+        // Notify only when the visible progress changes - every percent,
+        // or every 64kb if the server didn't send the image size
+        bool changed;
+        if (image_size > 0) {
+            int percent = (int)((int64_t)image_len_read * 100 / image_size);
+            changed = percent != progress.percent;
+            progress.percent = percent;
+        } else {
+            int kb_step = image_len_read / (64 * 1024);
+            changed = kb_step != last_kb_step;
+            last_kb_step = kb_step;
+        }
+        if (changed) {
+            progress.bytes_read = image_len_read;
+            ESP_ERROR_CHECK(esp_event_post(TUX_EVENTS, TUX_EVENT_OTA_IN_PROGRESS, &progress,sizeof(progress), portMAX_DELAY));
         }
-
     }
     
+    // Status text only - TUX_EVENT_OTA_IN_PROGRESS carries ota_progress_t
     strcpy(ota_reason,"Download completed");
-    ESP_ERROR_CHECK(esp_event_post(TUX_EVENTS, TUX_EVENT_OTA_IN_PROGRESS, ota_reason,sizeof(ota_reason), portMAX_DELAY));        
+    ESP_ERROR_CHECK(esp_event_post(TUX_EVENTS, TUX_EVENT_OTA_STARTED, ota_reason,sizeof(ota_reason), portMAX_DELAY));        
 
     if (esp_https_ota_is_complete_data_received(https_ota_handle) != true) {
         // the OTA image was not completely received and user can customise the response to this situation.
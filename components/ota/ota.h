@@ -7,6 +7,12 @@
 extern "C" {
 #endif
 
+// Payload of TUX_EVENT_OTA_IN_PROGRESS
+typedef struct {
+    int percent;        // -1 if the image size is not known
+    int bytes_read;
+} ota_progress_t;
+
 void run_ota_task(void *pvParameter);
 
 #ifdef __cplusplus
@@ -0,0 +1,173 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Compressed OTA - the image is served zlib compressed (ESP32-TUX.bin.zz,
+    webserver.py makes it on the fly) and inflated while it downloads with
+    the tinfl decompressor in ROM, so no decompression code is linked in.
+    RAM is fixed: the 32KB inflate window, the decompressor state and two
+    4KB buffers. The zlib adler32 is checked by tinfl, the image itself by
+    esp_ota_end() like a plain download.
+
+    esp_https_ota's decrypt_cb hook is not used for this: it parses the app
+    description from the first read alone, which a compressed stream can't
+    promise to cover.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "miniz.h"
+#include "ota.h"
+#include "ota_compressed.h"
+
+#if !defined(CONFIG_OTA_COMPRESSED_URL)
+#define CONFIG_OTA_COMPRESSED_URL "https://192.168.1.128/build/ESP32-TUX.bin.zz"
+#endif
+
+static const char *TAG = "OTA-ZLIB";
+
+#define OTA_Z_IN_SIZE 4096
+
+typedef struct {
+    tinfl_decompressor inflator;
+    uint8_t in[OTA_Z_IN_SIZE];
+    ota_writer_t w;
+    esp_http_client_handle_t client;
+    uint32_t compressed;                // bytes downloaded
+    int content_length;                 // -1 when chunked
+    ota_progress_t progress;
+} ota_z_ctx_t;
+
+static void ota_z_progress(ota_z_ctx_t *z)
+{
+    // Percent of the download, the image size is only known at the end
+    int percent = z->content_length > 0 ? (int)((int64_t)z->compressed * 100 / z->content_length) : -1;
+    bool changed = z->content_length > 0 ? percent != z->progress.percent
+                                         : z->compressed / (64 * 1024) != z->progress.bytes_read / (64 * 1024);
+    if (!changed) return;
+    z->progress.percent = percent;
+    z->progress.bytes_read = z->compressed;
+    esp_event_post(TUX_EVENTS, TUX_EVENT_OTA_IN_PROGRESS, &z->progress, sizeof(z->progress), portMAX_DELAY);
+}
+
+// Download -> tinfl -> writer until the zlib stream ends
+static esp_err_t ota_z_inflate(ota_z_ctx_t *z, uint8_t *dict)
+{
+    size_t in_pos = 0, in_len = 0, dict_ofs = 0;
+    bool eof = false;
+    tinfl_init(&z->inflator);
+
+    while (true) {
+        if (in_pos == in_len && !eof) {
+            int r = esp_http_client_read(z->client, (char *)z->in, sizeof(z->in));
+            if (r < 0) return ESP_FAIL;
+            eof = r == 0;
+            in_pos = 0;
+            in_len = r;
+            z->compressed += r;
+            ota_z_progress(z);
+        }
+
+        size_t in_bytes = in_len - in_pos;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - dict_ofs;
+        mz_uint32 flags = TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32 |
+                          (eof ? 0 : TINFL_FLAG_HAS_MORE_INPUT);
+        tinfl_status status = tinfl_decompress(&z->inflator, z->in + in_pos, &in_bytes,
+                                               dict, dict + dict_ofs, &out_bytes, flags);
+        in_pos += in_bytes;
+
+        if (out_bytes > 0) {
+            esp_err_t err = ota_writer_write(&z->w, dict + dict_ofs, out_bytes);
+            if (err != ESP_OK) return err;
+            dict_ofs = (dict_ofs + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+
+        if (status == TINFL_STATUS_DONE) return ESP_OK;
+        if (status == TINFL_STATUS_ADLER32_MISMATCH) return ESP_ERR_INVALID_CRC;
+        if (status < 0) {
+            ESP_LOGE(TAG, "Inflate failed (%d) after %" PRIu32 " bytes", status, z->compressed);
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && eof) return ESP_ERR_INVALID_SIZE;   // cut short
+    }
+}
+
+esp_err_t ota_compressed_run(const esp_http_client_config_t *http_config, ota_validate_cb_t validate)
+{
+    int64_t start = esp_timer_get_time();
+    ota_z_ctx_t *z = calloc(1, sizeof(ota_z_ctx_t));
+    uint8_t *dict = heap_caps_malloc(TINFL_LZ_DICT_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (dict == NULL) dict = malloc(TINFL_LZ_DICT_SIZE);
+    if (z == NULL || dict == NULL) {
+        free(z);
+        heap_caps_free(dict);
+        return ESP_ERR_NO_MEM;
+    }
+    z->progress.percent = -1;
+
+    esp_http_client_config_t config = *http_config;
+    config.url = CONFIG_OTA_COMPRESSED_URL;
+    z->client = esp_http_client_init(&config);
+    esp_err_t err = z->client ? esp_http_client_open(z->client, 0) : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) {
+        z->content_length = esp_http_client_fetch_headers(z->client);
+        int status = esp_http_client_get_status_code(z->client);
+        if (status != 200) {
+            ESP_LOGI(TAG, "No compressed image at %s (HTTP %d)", config.url, status);
+            err = ESP_ERR_NOT_FOUND;
+        }
+    }
+    if (err == ESP_OK) err = ota_writer_init(&z->w, OTA_WITH_SEQUENTIAL_WRITES, validate);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Inflating %s into %s, %d bytes compressed, %u bytes RAM",
+                    config.url, z->w.update->label, z->content_length,
+                    (unsigned)(sizeof(ota_z_ctx_t) + TINFL_LZ_DICT_SIZE));
+        err = ota_z_inflate(z, dict);
+    }
+    if (err == ESP_OK) err = ota_writer_finish(&z->w);
+    ota_writer_abort(&z->w);
+
+    if (err == ESP_OK) {
+        int64_t us = esp_timer_get_time() - start;
+        uint32_t written = z->w.written;
+        ESP_LOGI(TAG, "%" PRIu32 " bytes compressed -> %" PRIu32 " byte image (%" PRIu32 "%%) in %lldms,"
+                      " download %" PRIu32 " KB/s compressed (%" PRIu32 " KB/s image), flash write %" PRIu32 " KB/s",
+                    z->compressed, written, (uint32_t)((uint64_t)z->compressed * 100 / written), us / 1000,
+                    (uint32_t)(z->compressed * 1000000LL / 1024 / us),
+                    (uint32_t)(written * 1000000LL / 1024 / us),
+                    z->w.flash_us ? (uint32_t)(written * 1000000LL / 1024 / z->w.flash_us) : 0);
+    }
+
+    if (z->client) esp_http_client_cleanup(z->client);
+    heap_caps_free(dict);
+    free(z);
+    return err;
+}
@@ -0,0 +1,25 @@
+#ifndef tux_ota_compressed_H
+#define tux_ota_compressed_H
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include "ota_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Downloads the zlib compressed image from CONFIG_OTA_COMPRESSED_URL and
+ * inflates it straight into the next OTA partition.
+ * ESP_OK - image written, verified and set as boot partition
+ * ESP_ERR_INVALID_VERSION - validate rejected the new image, nothing to do
+ * anything else - download the plain image instead
+ */
+esp_err_t ota_compressed_run(const esp_http_client_config_t *http_config, ota_validate_cb_t validate);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif
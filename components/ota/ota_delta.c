@@ -0,0 +1,265 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Delta OTA - the new image is rebuilt from the running one plus a patch
+    made on the build host by ota_delta.py (format described there). The
+    patch is streamed: COPY ops read from the running partition, INSERT ops
+    come from the download, both are written in order into the next OTA
+    partition while the result is hashed. Before anything is erased the
+    running image is checked against the source sha256 in the patch header,
+    a patch made for another firmware means a full download instead.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "mbedtls/sha256.h"
+#include "ota.h"
+#include "ota_delta.h"
+
+#if !defined(CONFIG_OTA_DELTA_URL)
+#define CONFIG_OTA_DELTA_URL "https://192.168.1.128/build/ESP32-TUX.patch"
+#endif
+
+static const char *TAG = "OTA-DELTA";
+
+#define DELTA_MAGIC "TUXD"
+#define DELTA_VERSION 1
+#define DELTA_BUF_SIZE 4096
+
+enum { DELTA_OP_END = 0, DELTA_OP_COPY = 1, DELTA_OP_INSERT = 2 };
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved[3];
+    uint32_t src_size;
+    uint8_t src_sha[32];
+    uint32_t dst_size;
+    uint8_t dst_sha[32];
+} delta_header_t;
+
+_Static_assert(sizeof(delta_header_t) == 80, "Must match HEADER in ota_delta.py");
+
+typedef struct {
+    esp_http_client_handle_t client;
+    uint8_t in[DELTA_BUF_SIZE];         // download
+    int in_pos, in_len;
+    ota_writer_t w;                     // image bytes produced go here
+    const esp_partition_t *running;
+    mbedtls_sha256_context sha;
+
+    delta_header_t hdr;
+    uint32_t patch_read;                // bytes downloaded
+    uint32_t copies, copied, inserts, inserted;
+    ota_progress_t progress;
+} delta_ctx_t;
+
+// Next n bytes of the patch into dst
+static esp_err_t delta_read(delta_ctx_t *d, void *dst, uint32_t n)
+{
+    uint8_t *p = (uint8_t *)dst;
+    while (n > 0) {
+        if (d->in_pos == d->in_len) {
+            int r = esp_http_client_read(d->client, (char *)d->in, sizeof(d->in));
+            if (r <= 0) return ESP_ERR_INVALID_SIZE;    // patch cut short
+            d->in_pos = 0;
+            d->in_len = r;
+            d->patch_read += r;
+        }
+        uint32_t chunk = MIN(n, (uint32_t)(d->in_len - d->in_pos));
+        memcpy(p, d->in + d->in_pos, chunk);
+        d->in_pos += chunk;
+        p += chunk;
+        n -= chunk;
+    }
+    return ESP_OK;
+}
+
+// Appends image bytes - hashed and handed to the writer
+static esp_err_t delta_emit(delta_ctx_t *d, const uint8_t *data, uint32_t len)
+{
+    mbedtls_sha256_update(&d->sha, data, len);
+    esp_err_t err = ota_writer_write(&d->w, data, len);
+    if (err != ESP_OK) return err;
+
+    // Same progress events as the full download, percent of the new image
+    int percent = (int)((int64_t)d->w.written * 100 / d->hdr.dst_size);
+    if (percent != d->progress.percent) {
+        d->progress.percent = percent;
+        d->progress.bytes_read = d->patch_read;
+        esp_event_post(TUX_EVENTS, TUX_EVENT_OTA_IN_PROGRESS, &d->progress, sizeof(d->progress), portMAX_DELAY);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t delta_copy(delta_ctx_t *d, uint32_t offset, uint32_t len)
+{
+    if ((uint64_t)offset + len > d->hdr.src_size) return ESP_ERR_INVALID_ARG;
+    d->copies++;
+    d->copied += len;
+    uint8_t buf[256];
+    while (len > 0) {
+        uint32_t n = MIN(len, sizeof(buf));
+        esp_err_t err = esp_partition_read(d->running, offset, buf, n);
+        if (err == ESP_OK) err = delta_emit(d, buf, n);
+        if (err != ESP_OK) return err;
+        offset += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t delta_insert(delta_ctx_t *d, uint32_t len)
+{
+    d->inserts++;
+    d->inserted += len;
+    uint8_t buf[256];
+    while (len > 0) {
+        uint32_t n = MIN(len, sizeof(buf));
+        esp_err_t err = delta_read(d, buf, n);
+        if (err == ESP_OK) err = delta_emit(d, buf, n);
+        if (err != ESP_OK) return err;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+// sha256 of the first src_size bytes of the running partition against the patch header
+static esp_err_t delta_check_source(delta_ctx_t *d)
+{
+    if (d->hdr.src_size == 0 || d->hdr.src_size > d->running->size) return ESP_ERR_INVALID_SIZE;
+
+    uint8_t sha[32];
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    esp_err_t err = ESP_OK;
+    uint8_t *buf = d->w.buf;            // writer not started yet
+    for (uint32_t off = 0; off < d->hdr.src_size && err == ESP_OK; off += OTA_WRITER_BUF_SIZE) {
+        uint32_t n = MIN(OTA_WRITER_BUF_SIZE, d->hdr.src_size - off);
+        err = esp_partition_read(d->running, off, buf, n);
+        if (err == ESP_OK) mbedtls_sha256_update(&ctx, buf, n);
+    }
+    mbedtls_sha256_finish(&ctx, sha);
+    mbedtls_sha256_free(&ctx);
+    if (err != ESP_OK) return err;
+    return memcmp(sha, d->hdr.src_sha, sizeof(sha)) == 0 ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
+
+// Runs the ops into the update partition, verifies the result
+static esp_err_t delta_apply(delta_ctx_t *d)
+{
+    while (true) {
+        uint8_t op;
+        uint32_t args[2];
+        esp_err_t err = delta_read(d, &op, 1);
+        if (err != ESP_OK) return err;
+
+        if (op == DELTA_OP_END) break;
+        if (op == DELTA_OP_COPY) {
+            err = delta_read(d, args, 8);
+            if (err == ESP_OK) err = delta_copy(d, args[0], args[1]);
+        } else if (op == DELTA_OP_INSERT) {
+            err = delta_read(d, args, 4);
+            if (err == ESP_OK) err = delta_insert(d, args[0]);
+        } else {
+            ESP_LOGE(TAG, "Bad op 0x%02x after %" PRIu32 " patch bytes", op, d->patch_read);
+            err = ESP_ERR_INVALID_STATE;
+        }
+        if (err != ESP_OK) return err;
+    }
+
+    uint8_t sha[32];
+    mbedtls_sha256_finish(&d->sha, sha);
+    if (d->w.written != d->hdr.dst_size || memcmp(sha, d->hdr.dst_sha, sizeof(sha)) != 0) {
+        ESP_LOGE(TAG, "Rebuilt image does not match the patch (%" PRIu32 " of %" PRIu32 " bytes)",
+                    d->w.written, d->hdr.dst_size);
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ota_writer_finish(&d->w);
+}
+
+esp_err_t ota_delta_run(const esp_http_client_config_t *http_config, ota_validate_cb_t validate)
+{
+    int64_t start = esp_timer_get_time();
+    delta_ctx_t *d = calloc(1, sizeof(delta_ctx_t));
+    if (d == NULL) return ESP_ERR_NO_MEM;
+    d->running = esp_ota_get_running_partition();
+    d->progress.percent = -1;
+    mbedtls_sha256_init(&d->sha);
+    mbedtls_sha256_starts(&d->sha, 0);
+
+    esp_http_client_config_t config = *http_config;
+    config.url = CONFIG_OTA_DELTA_URL;
+    d->client = esp_http_client_init(&config);
+    esp_err_t err = d->client ? esp_http_client_open(d->client, 0) : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) {
+        esp_http_client_fetch_headers(d->client);
+        int status = esp_http_client_get_status_code(d->client);
+        if (status != 200) {
+            ESP_LOGI(TAG, "No patch at %s (HTTP %d)", config.url, status);
+            err = ESP_ERR_NOT_FOUND;
+        }
+    }
+    if (err == ESP_OK) err = delta_read(d, &d->hdr, sizeof(d->hdr));
+    if (err == ESP_OK && (memcmp(d->hdr.magic, DELTA_MAGIC, 4) != 0 || d->hdr.version != DELTA_VERSION)) {
+        ESP_LOGW(TAG, "Not a v%d patch", DELTA_VERSION);
+        err = ESP_ERR_NOT_SUPPORTED;
+    }
+    if (err == ESP_OK) {
+        err = delta_check_source(d);
+        if (err != ESP_OK) ESP_LOGW(TAG, "Patch is for another firmware than the running one");
+    }
+
+    if (err == ESP_OK) err = ota_writer_init(&d->w, d->hdr.dst_size, validate);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Patching %s (%" PRIu32 " bytes) into %s (%" PRIu32 " bytes)",
+                    d->running->label, d->hdr.src_size, d->w.update->label, d->hdr.dst_size);
+        err = delta_apply(d);
+    }
+    ota_writer_abort(&d->w);
+    if (err == ESP_OK) {
+        int64_t us = esp_timer_get_time() - start;
+        uint32_t permille = (uint64_t)d->patch_read * 1000 / d->w.written;
+        ESP_LOGI(TAG, "Patch %" PRIu32 " bytes for a %" PRIu32 " byte image (%" PRIu32 ".%" PRIu32 "%%) in %lldms,"
+                      " %" PRIu32 " copies / %" PRIu32 " bytes, %" PRIu32 " inserts / %" PRIu32 " bytes",
+                    d->patch_read, d->w.written, permille / 10, permille % 10, us / 1000,
+                    d->copies, d->copied, d->inserts, d->inserted);
+    }
+
+    if (d->client) esp_http_client_cleanup(d->client);
+    mbedtls_sha256_free(&d->sha);
+    free(d);
+    return err;
+}
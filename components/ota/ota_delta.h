@@ -0,0 +1,25 @@
+#ifndef tux_ota_delta_H
+#define tux_ota_delta_H
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include "ota_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Downloads the patch from CONFIG_OTA_DELTA_URL and rebuilds the new image
+ * from the running partition into the next OTA partition (see ota_delta.py).
+ * ESP_OK - image written, verified and set as boot partition
+ * ESP_ERR_INVALID_VERSION - validate rejected the new image, nothing to do
+ * anything else - no usable patch, download the full image instead
+ */
+esp_err_t ota_delta_run(const esp_http_client_config_t *http_config, ota_validate_cb_t validate);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string.h>
+#include <inttypes.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ota_writer.h"
+
+static const char *TAG = "OTA-WRITER";
+
+esp_err_t ota_writer_init(ota_writer_t *w, uint32_t image_size, ota_validate_cb_t validate)
+{
+    memset(w, 0, sizeof(*w));
+    w->update = esp_ota_get_next_update_partition(NULL);
+    w->image_size = image_size;
+    w->validate = validate;
+    if (w->update == NULL) return ESP_ERR_NOT_FOUND;
+    if (image_size != OTA_WITH_SEQUENTIAL_WRITES && image_size > w->update->size) {
+        ESP_LOGE(TAG, "Image of %" PRIu32 " bytes does not fit %s", image_size, w->update->label);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ota_writer_flush(ota_writer_t *w)
+{
+    if (w->buf_len == 0) return ESP_OK;
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+    if (!w->begun) {
+        err = esp_ota_begin(w->update, w->image_size, &w->handle);
+        w->begun = err == ESP_OK;
+    }
+    if (err == ESP_OK) err = esp_ota_write(w->handle, w->buf, w->buf_len);
+    w->buf_len = 0;
+    w->flash_us += esp_timer_get_time() - start;
+    return err;
+}
+
+esp_err_t ota_writer_write(ota_writer_t *w, const uint8_t *data, uint32_t len)
+{
+    if (w->image_size != OTA_WITH_SEQUENTIAL_WRITES ? w->written + len > w->image_size
+                                                    : w->written + len > w->update->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (w->written < OTA_APP_DESC_END) {
+        uint32_t n = MIN(len, OTA_APP_DESC_END - w->written);
+        memcpy(w->head + w->written, data, n);
+        if (w->written + n == OTA_APP_DESC_END && w->validate &&
+            w->validate((esp_app_desc_t *)(w->head + OTA_APP_DESC_OFFSET)) != ESP_OK) {
+            return ESP_ERR_INVALID_VERSION;
+        }
+    }
+    w->written += len;
+
+    while (len > 0) {
+        uint32_t n = MIN(len, sizeof(w->buf) - w->buf_len);
+        memcpy(w->buf + w->buf_len, data, n);
+        w->buf_len += n;
+        data += n;
+        len -= n;
+        if (w->buf_len == sizeof(w->buf)) {
+            esp_err_t err = ota_writer_flush(w);
+            if (err != ESP_OK) return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t ota_writer_finish(ota_writer_t *w)
+{
+    if (w->written < OTA_APP_DESC_END) return ESP_ERR_INVALID_SIZE;
+    esp_err_t err = ota_writer_flush(w);
+    if (err != ESP_OK) return err;
+    w->begun = false;
+    err = esp_ota_end(w->handle);
+    if (err == ESP_OK) err = esp_ota_set_boot_partition(w->update);
+    return err;
+}
+
+void ota_writer_abort(ota_writer_t *w)
+{
+    if (w->begun) esp_ota_abort(w->handle);
+    w->begun = false;
+}
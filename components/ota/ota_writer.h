@@ -0,0 +1,54 @@
+#ifndef tux_ota_writer_H
+#define tux_ota_writer_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_app_desc.h"
+#include "esp_app_format.h"
+#include "esp_ota_ops.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTA_WRITER_BUF_SIZE 4096
+
+// Where the app description sits in an image - validated once these bytes are in
+#define OTA_APP_DESC_OFFSET (sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t))
+#define OTA_APP_DESC_END (OTA_APP_DESC_OFFSET + sizeof(esp_app_desc_t))
+
+// Checks the app description of the new image, ESP_OK to go ahead
+typedef esp_err_t (*ota_validate_cb_t)(esp_app_desc_t *new_app_info);
+
+/*
+ * Image bytes produced on the device (delta, decompressed) into the next OTA
+ * partition. Writes are collected into OTA_WRITER_BUF_SIZE blocks, the
+ * partition is only erased (esp_ota_begin) once the app description passed
+ * validate - an unchanged version costs no flash erase.
+ */
+typedef struct {
+    const esp_partition_t *update;
+    esp_ota_handle_t handle;
+    bool begun;                         // esp_ota_begin() done - erasing and writing
+    uint32_t image_size;                // OTA_WITH_SEQUENTIAL_WRITES when not known
+    ota_validate_cb_t validate;
+    uint8_t head[OTA_APP_DESC_END];
+    uint8_t buf[OTA_WRITER_BUF_SIZE];
+    uint32_t buf_len;
+    uint32_t written;                   // image bytes taken
+    int64_t flash_us;                   // spent in esp_ota_begin/write
+} ota_writer_t;
+
+esp_err_t ota_writer_init(ota_writer_t *w, uint32_t image_size, ota_validate_cb_t validate);
+// ESP_ERR_INVALID_VERSION when validate rejected the image
+esp_err_t ota_writer_write(ota_writer_t *w, const uint8_t *data, uint32_t len);
+// Flushes, esp_ota_end() (image verification) and sets the boot partition
+esp_err_t ota_writer_finish(ota_writer_t *w);
+void ota_writer_abort(ota_writer_t *w);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif
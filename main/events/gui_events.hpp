@@ -55,6 +55,10 @@ extern "C" {
 #define MSG_TIME_CHANGED        100
 #define MSG_WEATHER_CHANGED     101
 
+// lv_timer control from other tasks, payload is the lv_timer_t*
+#define MSG_TIMER_READY         110
+#define MSG_TIMER_PAUSE         111
+
 #ifdef __cplusplus
 }
 #endif
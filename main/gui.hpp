@@ -32,6 +32,8 @@ SOFTWARE.
 #include <esp_partition.h>
 
 LV_IMG_DECLARE(dev_bg)
+#define TUX_WALLPAPER   "F:/bg/dev_bg9.bin"
+#define TUX_SPLASH_LOGO "F:/bg/tux-logo.bin"
 //LV_IMG_DECLARE(tux_logo)
 
 // LV_FONT_DECLARE(font_7seg_64)
@@ -61,6 +63,9 @@ static const lv_font_t *font_symbol;
 static const lv_font_t *font_fa;
 static const lv_font_t *font_xl;
 static const lv_font_t *font_xxl;
+static const lv_font_t *font_clock_base;    // 7 segment from the font store or linked in
+static const lv_font_t *font_clock;         // same, through the glyph cache when enabled
+static const lv_font_t *font_weather;       // weather icons, CONFIG_TUX_WEATHER_ICON_SIZE
 
 static lv_obj_t *panel_header;
 static lv_obj_t *panel_title;
@@ -145,6 +150,10 @@ static void create_page_settings(lv_obj_t *parent);
 static void create_page_updates(lv_obj_t *parent);
 static void create_page_remote(lv_obj_t *parent);
 
+// Page manager - pages are built once and kept hidden
+static int64_t page_show(int page_id);
+static void page_evict(int page_id);
+
 // Home page islands
 static void tux_panel_clock_weather(lv_obj_t *parent);
 static void tux_panel_config(lv_obj_t *parent);
@@ -165,6 +174,10 @@ static void show_ui();
 
 static const char* get_firmware_version();
 
+#if defined(CONFIG_TUX_UI_BENCHMARK)
+static void ui_benchmark_task(void *param);
+#endif
+
 static void rotate_event_handler(lv_event_t *e);
 static void theme_switch_event_handler(lv_event_t *e);
 static void espwifi_event_handler(lv_event_t* e);
@@ -182,10 +195,16 @@ void weather_event_cb(lv_event_t * e);
 
 static void status_change_cb(void * s, lv_msg_t *m);
 static void lv_update_battery(uint batval);
+static bool lv_label_set_text_changed(lv_obj_t *label, const char *text);
 static void set_weather_icon(string weatherIcon);
 
 static int current_page = 0;
 
+// Last rendered clock minute / battery level, reset when the widgets are recreated
+static int datetime_rendered_key = -1;
+static int battery_rendered_level = -1;
+static bool weather_rendered = false;      // widgets show the current values
+
 void lv_setup_styles()
 {
     font_symbol = &lv_font_montserrat_14;
@@ -195,6 +214,25 @@ void lv_setup_styles()
     font_xxl = &lv_font_montserrat_32;
     font_fa = &font_fa_14;
 
+    // Big glyph fonts from F:/fonts (or S:/fonts), the linked-in ones when the file is missing
+    font_clock_base = font_store_acquire(TUX_FONT_CLOCK, TUX_FONT_BUILTIN(font_7seg_56));
+    const lv_font_t *weather = font_store_weather(CONFIG_TUX_WEATHER_ICON_SIZE, TUX_FONT_BUILTIN(font_fa_weather_42));
+    if (font_clock_base == NULL) {
+        ESP_LOGE(TAG, "No clock font - %s missing and none linked in", TUX_FONT_CLOCK);
+        font_clock_base = font_xxl;
+    }
+    if (weather == NULL) {
+        ESP_LOGE(TAG, "No weather icon font - icons will not show");
+        weather = font_xxl;
+    }
+
+    // Big glyphs redrawn every minute / weather update - decoded once into PSRAM
+    font_clock = glyph_cache_wrap(font_clock_base);
+    font_weather = glyph_cache_wrap(weather);
+#if defined(CONFIG_TUX_CLOCK_DIGIT_ATLAS)
+    glyph_cache_atlas(font_clock, "0123456789:");
+#endif
+
     screen_h = lv_obj_get_height(lv_scr_act());
     screen_w = lv_obj_get_width(lv_scr_act());
 
@@ -209,8 +247,9 @@ void lv_setup_styles()
     // CF_INDEXED_8_BIT for smaller size - resolution 480x480
     // NOTE: Dynamic loading bg from SPIFF makes screen perf bad
     if (lv_fs_is_ready('F')) { // NO SD CARD load default
-        ESP_LOGW(TAG,"Loading - F:/bg/dev_bg9.bin");
-        lv_style_set_bg_img_src(&style_content_bg, "F:/bg/dev_bg9.bin");    
+        // PSRAM copy when there is one - drawn from memory instead of SPIFFS
+        ESP_LOGW(TAG,"Loading - %s", TUX_WALLPAPER);
+        lv_style_set_bg_img_src(&style_content_bg, asset_acquire(TUX_WALLPAPER));    
     } else {
         ESP_LOGW(TAG,"Loading - from firmware");
         lv_style_set_bg_img_src(&style_content_bg, &dev_bg);
@@ -350,6 +389,7 @@ static void create_header(lv_obj_t *parent)
 
     // BATTERY
     icon_battery = lv_label_create(panel_status);
+    battery_rendered_level = -1;
     lv_label_set_text(icon_battery, LV_SYMBOL_CHARGE);
     lv_obj_add_style(icon_battery, &style_battery, 0);
 
@@ -431,8 +471,9 @@ static void tux_panel_clock_weather(lv_obj_t *parent)
 
     // Time
     lbl_time = lv_label_create(cont_datetime);
+    datetime_rendered_key = -1;
     lv_obj_set_style_align(lbl_time, LV_ALIGN_TOP_LEFT, 0);
-    lv_obj_set_style_text_font(lbl_time, &font_7seg_56, 0);
+    lv_obj_set_style_text_font(lbl_time, font_clock, 0);
     lv_label_set_text(lbl_time, "00:00");
 
     // AM/PM
@@ -458,6 +499,7 @@ static void tux_panel_clock_weather(lv_obj_t *parent)
     lv_obj_set_style_border_opa(cont_weather,LV_OPA_TRANSP,0);
 
     // MSG - MSG_WEATHER_CHANGED - EVENT
+    weather_rendered = false;
     lv_obj_add_event_cb(cont_weather, weather_event_cb, LV_EVENT_MSG_RECEIVED, NULL);
     lv_msg_subsribe_obj(MSG_WEATHER_CHANGED, cont_weather, NULL);
 
@@ -468,7 +510,7 @@ static void tux_panel_clock_weather(lv_obj_t *parent)
 
     // Weather icons
     lbl_weathericon = lv_label_create(cont_weather);
-    lv_obj_set_style_text_font(lbl_weathericon, &font_fa_weather_42, 0);
+    lv_obj_set_style_text_font(lbl_weathericon, font_weather, 0);
     // "F:/weather/cloud-sun-rain.bin");//10d@2x.bin"
     lv_label_set_text(lbl_weathericon, FA_WEATHER_SUN);
     lv_obj_set_style_text_color(lbl_weathericon,lv_palette_main(LV_PALETTE_ORANGE),0);
@@ -493,6 +535,10 @@ static void slider_event_cb(lv_event_t * e)
     lv_label_set_text_fmt(slider_label,"Brightness : %d",(int)lv_slider_get_value(slider));
     lv_obj_align_to(slider_label, slider, LV_ALIGN_OUT_BOTTOM_MID, 0, 15);
     lcd.setBrightness((int)lv_slider_get_value(slider));
+
+    // A drag fires this for every step, the debounced save writes once after release
+    cfg->Brightness = (uint8_t)lv_slider_get_value(slider);
+    cfg->save_later();
 }
 
 static void tux_panel_config(lv_obj_t *parent)
@@ -642,7 +688,7 @@ static void tux_panel_ota(lv_obj_t *parent)
 
 static void tux_panel_devinfo(lv_obj_t *parent)
 {
-    island_devinfo = tux_panel_create(parent, LV_SYMBOL_TINT " DEVICE INFO", 200);
+    island_devinfo = tux_panel_create(parent, LV_SYMBOL_TINT " DEVICE INFO", 260);
     lv_obj_add_style(island_devinfo, &style_ui_island, 0);
 
     // Get Content Area to add UI elements
@@ -713,12 +759,157 @@ static void create_page_updates(lv_obj_t *parent)
     tux_panel_devinfo(parent);    
 }
 
+/*
+    Page manager
+    Each page lives in its own container inside content_container. It is
+    built on first visit and only hidden when another page is shown, so a
+    footer tap costs a flag toggle instead of lv_obj_clean() + rebuild.
+    When the LVGL pool (LV_MEM_SIZE) runs low the least recently used
+    hidden page is deleted and rebuilt on its next visit.
+*/
+typedef struct {
+    const char *name;
+    void (*create)(lv_obj_t *parent);
+    lv_obj_t *root;             // NULL until built or after eviction
+    uint32_t last_used;         // lv_tick_get() of the last visit
+} tux_page_t;
+
+// Indexed by MSG_PAGE_xxx
+static tux_page_t tux_pages[] = {
+    { "home",     create_page_home,     NULL, 0 },
+    { "remote",   create_page_remote,   NULL, 0 },
+    { "settings", create_page_settings, NULL, 0 },
+    { "updates",  create_page_updates,  NULL, 0 },
+};
+static constexpr int TUX_PAGE_COUNT = sizeof(tux_pages) / sizeof(tux_pages[0]);
+
+static constexpr uint32_t PAGE_MIN_FREE = CONFIG_TUX_PAGE_MIN_FREE_KB * 1024;
+
+// Page widgets are gone - don't let status updates touch them
+static void page_deleted_cb(lv_event_t *e)
+{
+    int page_id = (int)(intptr_t)lv_event_get_user_data(e);
+    tux_pages[page_id].root = NULL;
+
+    switch (page_id)
+    {
+        case MSG_PAGE_HOME:
+            tux_clock_weather = NULL;
+            lbl_time = lbl_ampm = lbl_date = NULL;
+            lbl_weathericon = lbl_temp = lbl_hl = NULL;
+            break;
+        case MSG_PAGE_SETTINGS:
+            island_wifi = prov_qr = qr_status_container = NULL;
+            lbl_wifi_status = lbl_scan_status = slider_label = NULL;
+            break;
+        case MSG_PAGE_OTA:
+            island_ota = island_devinfo = NULL;
+            lbl_version = lbl_update_status = lbl_device_info = NULL;
+            break;
+    }
+}
+
+// Memory cached pages compete for - the LVGL pool, or internal RAM with the heap
+// based allocator (widgets are small and stay internal, PSRAM has megabytes free)
+static uint32_t page_mem_free()
+{
+#if LV_MEM_CUSTOM
+    tux_mem_stats_t st;
+    tux_mem_get_stats(&st);
+    return st.free_internal;
+#else
+    tux_lv_mem_t mem;
+    lv_mem_usage(&mem);
+    return mem.free;
+#endif
+}
+
+static void page_evict(int page_id)
+{
+    if (tux_pages[page_id].root == NULL) return;
+    ESP_LOGW(TAG, "Evicting page '%s'", tux_pages[page_id].name);
+    lv_obj_del(tux_pages[page_id].root);    // page_deleted_cb clears the references
+}
+
+// Delete least recently used hidden pages until the pool has some room again
+static void page_evict_lru(int keep_page)
+{
+    while (page_mem_free() < PAGE_MIN_FREE) {
+        int lru = -1;
+        for (int i = 0; i < TUX_PAGE_COUNT; i++) {
+            if (i == keep_page || i == current_page || tux_pages[i].root == NULL) continue;
+            if (lru < 0 || tux_pages[i].last_used < tux_pages[lru].last_used) lru = i;
+        }
+        if (lru < 0) break;     // nothing left to give back
+        page_evict(lru);
+    }
+}
+
+static lv_obj_t *page_build(int page_id)
+{
+    // Same layout as content_container had when pages were created directly in it
+    lv_obj_t *root = lv_obj_create(content_container);
+    lv_obj_remove_style_all(root);
+    lv_obj_set_size(root, LV_PCT(100), LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(root, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_style_pad_row(root, lv_obj_get_style_pad_row(content_container, LV_PART_MAIN), 0);
+    lv_obj_clear_flag(root, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_event_cb(root, page_deleted_cb, LV_EVENT_DELETE, (void *)(intptr_t)page_id);
+
+    tux_pages[page_id].create(root);
+    return root;
+}
+
+// Show page_id and hide the others, returns the switch time in us
+static int64_t page_show(int page_id)
+{
+    if (page_id < 0 || page_id >= TUX_PAGE_COUNT) return 0;
+
+    int64_t start = esp_timer_get_time();
+    tux_page_t *page = &tux_pages[page_id];
+    bool built = false;
+
+    if (page->root == NULL) {
+#if defined(CONFIG_TUX_PAGE_CACHE)
+        page_evict_lru(page_id);
+#else
+        // No caching - only one page alive at a time like before
+        for (int i = 0; i < TUX_PAGE_COUNT; i++) if (i != page_id) page_evict(i);
+#endif
+        page->root = page_build(page_id);
+        built = true;
+    }
+
+    for (int i = 0; i < TUX_PAGE_COUNT; i++) {
+        if (tux_pages[i].root == NULL) continue;
+        if (i == page_id) lv_obj_clear_flag(tux_pages[i].root, LV_OBJ_FLAG_HIDDEN);
+        else lv_obj_add_flag(tux_pages[i].root, LV_OBJ_FLAG_HIDDEN);
+    }
+    lv_obj_scroll_to_y(content_container, 0, LV_ANIM_OFF);
+
+    page->last_used = lv_tick_get();
+    current_page = page_id;
+
+#if defined(CONFIG_TUX_PAGE_CACHE)
+    // A fresh page may have used the last of the pool - make room for the next one
+    if (built) page_evict_lru(page_id);
+#endif
+
+    int64_t elapsed = esp_timer_get_time() - start;
+    tux_lv_mem_t mem;
+    lv_mem_usage(&mem);
+    ESP_LOGI(TAG, "Page '%s' %s in %lldus, lv_mem used:%" PRIu32 " free:%" PRIu32 " frag:%d%%",
+                page->name, built ? "built" : "shown", elapsed,
+                mem.used, mem.free, mem.frag_pct);
+    return elapsed;
+}
+
 static void create_splash_screen()
 {
     lv_obj_t * splash_screen = lv_scr_act();
     lv_obj_set_style_bg_color(splash_screen, lv_color_black(),0);
     lv_obj_t * splash_img = lv_img_create(splash_screen);
-    lv_img_set_src(splash_img, "F:/bg/tux-logo.bin"); //&tux_logo);
+    asset_img_set_src(splash_img, TUX_SPLASH_LOGO); //&tux_logo);
     lv_obj_align(splash_img, LV_ALIGN_CENTER, 0, 0);
 
     //lv_scr_load_anim(splash_screen, LV_SCR_LOAD_ANIM_FADE_IN, 5000, 10, true);
@@ -753,9 +944,7 @@ static void show_ui()
     lv_obj_set_flex_flow(content_container, LV_FLEX_FLOW_COLUMN);
 
     // Show Home Page
-    create_page_home(content_container);
-    //create_page_settings(content_container);
-    //create_page_remote(content_container);
+    page_show(MSG_PAGE_HOME);
 
     // Load main screen with animation
     //lv_scr_load(screen_container);
@@ -774,6 +963,173 @@ static void show_ui()
     lv_msg_send(MSG_PAGE_HOME,NULL);
 }
 
+#if defined(CONFIG_TUX_UI_BENCHMARK)
+/*
+    Scripted frame benchmark - drives every page through a fixed set of frames
+    Frame 0 draws the whole page, the remaining frames scroll the content
+    up and down which is what the UI does most of the time.
+    Results are printed over serial (see helper_perf.hpp)
+*/
+static void ui_benchmark_task(void *param)
+{
+    // Let the screen load animation finish
+    vTaskDelay(pdMS_TO_TICKS(2000));
+    ESP_LOGW(TAG, "UI benchmark started : %d frames per page", CONFIG_TUX_UI_BENCHMARK_FRAMES);
+    lv_draw_buf_report();
+
+    // Page switch latency - first visit builds the page, second one is cached
+    int64_t switch_us[TUX_PAGE_COUNT][2];
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int p = 0; p < TUX_PAGE_COUNT; p++)
+        {
+            if (pass == 0 && p != MSG_PAGE_HOME) {
+                lvgl_acquire();
+                page_evict(p);      // cold start for every page but the visible one
+                lvgl_release();
+            }
+            lvgl_acquire();
+            int64_t start = esp_timer_get_time();
+            page_show(p);
+            lv_refr_now(disp);
+            switch_us[p][pass] = esp_timer_get_time() - start;
+            lvgl_release();
+            vTaskDelay(pdMS_TO_TICKS(50));
+        }
+    }
+
+    for (int p = 0; p < TUX_PAGE_COUNT; p++)
+    {
+        ESP_LOGW(TAG, "[%s] page switch incl. render : first %lldus, cached %lldus%s",
+                    tux_pages[p].name, switch_us[p][0], switch_us[p][1],
+                    tux_pages[p].root ? "" : " (evicted)");
+    }
+    lvgl_acquire();
+    lv_mem_report("all pages");
+    lvgl_release();
+
+    // Frame times
+    for (int p = 0; p < TUX_PAGE_COUNT; p++)
+    {
+        lvgl_acquire();
+        page_show(p);
+        lv_obj_update_layout(content_container);
+        perf_reset();
+
+        for (int frame = 0; frame < CONFIG_TUX_UI_BENCHMARK_FRAMES; frame++)
+        {
+            if (frame == 0) {
+                lv_obj_invalidate(content_container);
+            } else {
+                // Scroll down for the first half and back up for the second half
+                lv_coord_t dy = (frame <= CONFIG_TUX_UI_BENCHMARK_FRAMES / 2) ? -10 : 10;
+                lv_obj_scroll_by(content_container, 0, dy, LV_ANIM_OFF);
+            }
+            lv_refr_now(disp);
+            perf_log_frame(tux_pages[p].name, frame);
+        }
+        perf_report(tux_pages[p].name);
+        lvgl_release();
+
+        // Give other tasks some air between pages
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+#if defined(CONFIG_TUX_ASSET_CACHE)
+    // Image draw cold (lv_fs reads from SPIFFS every frame) vs. warm (PSRAM copy)
+    {
+        int64_t draw_us[2];
+        lvgl_acquire();
+        lv_obj_t *img = lv_img_create(lv_layer_top());
+        lv_obj_center(img);
+        const void *cached = asset_acquire(TUX_SPLASH_LOGO);
+        for (int warm = 0; warm < 2; warm++) {
+            lv_img_set_src(img, warm ? cached : TUX_SPLASH_LOGO);
+            lv_refr_now(disp);
+            int64_t start = esp_timer_get_time();
+            for (int i = 0; i < 10; i++) {
+                lv_obj_invalidate(img);
+                lv_refr_now(disp);
+            }
+            draw_us[warm] = (esp_timer_get_time() - start) / 10;
+        }
+        lv_obj_del(img);
+        asset_release(cached);
+        lvgl_release();
+        ESP_LOGW(TAG, "[image] %s draw : cold %lldus, warm %lldus", TUX_SPLASH_LOGO, draw_us[0], draw_us[1]);
+        asset_report();
+    }
+#endif
+
+    // Clock redraw with the plain 4bpp font vs. the glyph cache (and atlas if built)
+    lvgl_acquire();
+    page_show(MSG_PAGE_HOME);
+    if (lbl_time && font_clock != font_clock_base) {
+        const lv_font_t *fonts[] = { font_clock_base, font_clock };
+        int64_t redraw_us[2];
+        for (int cached = 0; cached < 2; cached++) {
+            lv_obj_set_style_text_font(lbl_time, fonts[cached], 0);
+            lv_label_set_text(lbl_time, "12:58");
+            lv_refr_now(disp);
+            int64_t start = esp_timer_get_time();
+            for (int i = 0; i < 20; i++) {
+                lv_label_set_text(lbl_time, (i & 1) ? "12:58" : "12:59");   // what a minute change does
+                lv_refr_now(disp);
+            }
+            redraw_us[cached] = (esp_timer_get_time() - start) / 20;
+        }
+        ESP_LOGW(TAG, "[clock] label redraw : 4bpp font %lldus, glyph cache %lldus", redraw_us[0], redraw_us[1]);
+        datetime_rendered_key = -1;     // real time again on the next tick
+    }
+    glyph_cache_report();
+    lvgl_release();
+
+    // Glyph lookup (descriptor + bitmap) per font the clock could use
+    {
+        const lv_font_t *fonts[] = { TUX_FONT_BUILTIN(font_7seg_56), font_clock_base, font_clock };
+        const char *names[] = { "linked-in", "clock font", "glyph cache" };
+        const char *digits = "0123456789:";
+        lvgl_acquire();
+        for (int f = 0; f < 3; f++) {
+            if (fonts[f] == NULL || (f > 0 && fonts[f] == fonts[f - 1])) continue;
+            lv_font_glyph_dsc_t dsc;
+            int64_t start = esp_timer_get_time();
+            for (int i = 0; i < 100; i++) {
+                for (const char *c = digits; *c; c++) {
+                    lv_font_get_glyph_dsc(fonts[f], &dsc, *c, 0);
+                    lv_font_get_glyph_bitmap(fonts[f], *c);
+                }
+            }
+            int64_t us = esp_timer_get_time() - start;
+            ESP_LOGW(TAG, "[fonts] %s glyph lookup : %lldns", names[f], us * 1000 / (100 * 11));
+        }
+        font_store_report();
+        lvgl_release();
+    }
+
+    // lv_fs throughput - small reads like decoders and font loaders do, and bigger ones
+    lvgl_acquire();
+    const char *fs_files[] = { TUX_SPLASH_LOGO, TUX_WALLPAPER, "S:/bg/dev_bg9.bin" };
+    for (const char *path : fs_files) {
+        if (!lv_fs_is_ready(path[0])) continue;
+        lv_fs_cache_benchmark(path, 32);
+        lv_fs_cache_benchmark(path, 32);    // again - warm if the file fits the cache
+        lv_fs_cache_benchmark(path, 1024);
+    }
+    lv_fs_cache_report();
+    lvgl_release();
+
+    // Back to where we started
+    lvgl_acquire();
+    page_show(MSG_PAGE_HOME);
+    lv_msg_send(MSG_PAGE_HOME, NULL);
+    lvgl_release();
+
+    ESP_LOGW(TAG, "UI benchmark completed");
+    vTaskDelete(NULL);
+}
+#endif
+
 static void rotate_event_handler(lv_event_t *e)
 {
     lv_event_code_t code = lv_event_get_code(e);
@@ -846,18 +1202,13 @@ static void footer_message(const char *fmt, ...)
 static void home_clicked_eventhandler(lv_event_t *e)
 {
     // footer_message("Home clicked!");
-    //  Clean the content container first
-    lv_obj_clean(content_container);
-    create_page_home(content_container);
+    page_show(MSG_PAGE_HOME);
 }
 
 static void status_clicked_eventhandler(lv_event_t *e)
 {
     // footer_message("Status icons touched but this is a very long message to show scroll animation!");
-    //  Clean the content container first
-    lv_obj_clean(content_container);
-    create_page_settings(content_container);
-    //create_page_remote(content_container);
+    page_show(MSG_PAGE_SETTINGS);
 }
 
 void switch_theme(bool dark)
@@ -966,6 +1317,15 @@ void datetime_event_cb(lv_event_t * e)
     if (code == LV_EVENT_MSG_RECEIVED)  
     {
         struct tm *dtinfo = (tm*)lv_msg_get_payload(m);
+
+        // Clock shows minutes - nothing to render until minute/day changes
+        int minute_key = (dtinfo->tm_yday * 24 + dtinfo->tm_hour) * 60 + dtinfo->tm_min;
+        if (minute_key == datetime_rendered_key) {
+            ui_state_stats.redraws_avoided++;
+            return;
+        }
+        datetime_rendered_key = minute_key;
+
         // Date & Time formatted
         char strftime_buf[64];
         // strftime(strftime_buf, sizeof(strftime_buf), "%c %z", dtinfo);
@@ -973,15 +1333,15 @@ void datetime_event_cb(lv_event_t * e)
 
         // Date formatted
         strftime(strftime_buf, sizeof(strftime_buf), "%a, %e %b %Y", dtinfo);
-        lv_label_set_text_fmt(lbl_date,"%s",strftime_buf);
+        lv_label_set_text_changed(lbl_date, strftime_buf);
 
         // Time in 12hrs 
         strftime(strftime_buf, sizeof(strftime_buf), "%I:%M", dtinfo);
-        lv_label_set_text_fmt(lbl_time, "%s", strftime_buf);        
+        lv_label_set_text_changed(lbl_time, strftime_buf);
 
         // 12hr clock AM/PM
         strftime(strftime_buf, sizeof(strftime_buf), "%p", dtinfo);
-        lv_label_set_text_fmt(lbl_ampm, "%s", strftime_buf);        
+        lv_label_set_text_changed(lbl_ampm, strftime_buf);
     }
 }
 
@@ -997,11 +1357,22 @@ void weather_event_cb(lv_event_t * e)
         e_owm = (OpenWeatherMap*)lv_msg_get_payload(m);
         //ESP_LOGW(TAG,"weather_event_cb %s",e_owm->LocationName.c_str());
 
+        // Redraw only what changed, everything on freshly built widgets
+        uint32_t changed = e_owm->take_changed();
+        if (!weather_rendered) {
+            changed = ~0u;
+            weather_rendered = true;
+        }
+
         // set this according to e_owm->WeatherIcon 
-        set_weather_icon(e_owm->WeatherIcon);      
+        if (changed & WF_ICON) set_weather_icon(e_owm->WeatherIcon);
+        else ui_state_stats.redraws_avoided++;
 
-        lv_label_set_text(lbl_temp,fmt::format("{:.1f}°{}",e_owm->Temperature,e_owm->TemperatureUnit).c_str());
-        lv_label_set_text(lbl_hl,fmt::format("H:{:.1f}° L:{:.1f}°",e_owm->TemperatureHigh,e_owm->TemperatureLow).c_str());
+        if (changed & WF_TEMP) lv_label_set_text_changed(lbl_temp,fmt::format("{:.1f}°{}",e_owm->Temperature,e_owm->TemperatureUnit).c_str());
+        else ui_state_stats.redraws_avoided++;
+
+        if (changed & (WF_TEMP_MIN | WF_TEMP_MAX)) lv_label_set_text_changed(lbl_hl,fmt::format("H:{:.1f}° L:{:.1f}°",e_owm->TemperatureHigh,e_owm->TemperatureLow).c_str());
+        else ui_state_stats.redraws_avoided++;
     }
 }
 
@@ -1019,33 +1390,11 @@ static void footer_button_event_handler(lv_event_t * e)
         if (current_page != page_id) current_page = page_id;
         else return;    // Skip if no page change
 
-        // HOME
-        if (page_id==MSG_PAGE_HOME)  {
-            lv_obj_clean(content_container);
-            create_page_home(content_container);
-            anim_move_left_x(content_container,screen_w,0,200);
-            lv_msg_send(MSG_PAGE_HOME,NULL);
-        } 
-        // REMOTE
-        else if (page_id == MSG_PAGE_REMOTE) {
-            lv_obj_clean(content_container);
-            create_page_remote(content_container);
-            anim_move_left_x(content_container,screen_w,0,200);
-            lv_msg_send(MSG_PAGE_REMOTE,NULL);
-        }
-        // SETTINGS
-        else if (page_id == MSG_PAGE_SETTINGS) {
-            lv_obj_clean(content_container);
-            create_page_settings(content_container);
-            anim_move_left_x(content_container,screen_w,0,200);
-            lv_msg_send(MSG_PAGE_SETTINGS,NULL);
-        }
-        // OTA UPDATES
-        else if (page_id == MSG_PAGE_OTA) {
-            lv_obj_clean(content_container);
-            create_page_updates(content_container);
+        // HOME / REMOTE / SETTINGS / OTA UPDATES - built once, then only shown
+        if ((int)page_id < TUX_PAGE_COUNT) {
+            page_show(page_id);
             anim_move_left_x(content_container,screen_w,0,200);
-            lv_msg_send(MSG_PAGE_OTA,NULL);
+            lv_msg_send(page_id,NULL);
         }
     }
 }
@@ -1066,6 +1415,9 @@ static void status_change_cb(void * s, lv_msg_t *m)
             lv_style_set_text_color(&style_wifi, lv_palette_main(LV_PALETTE_GREY));
             lv_label_set_text(icon_wifi, LV_SYMBOL_WIFI);
 
+            // Settings page may not be built (or evicted)
+            if (prov_qr == NULL) break;
+
             char qr_data[150] = {0};
             snprintf(qr_data,sizeof(qr_data),"%s",(const char*)lv_msg_get_payload(m));
             lv_qrcode_update(prov_qr, qr_data, strlen(qr_data));
@@ -1078,7 +1430,7 @@ static void status_change_cb(void * s, lv_msg_t *m)
             lv_style_set_text_color(&style_wifi, lv_palette_main(LV_PALETTE_BLUE));
             lv_label_set_text(icon_wifi, LV_SYMBOL_WIFI);
 
-            if (lv_msg_get_payload(m) != NULL) {
+            if (lv_msg_get_payload(m) != NULL && lbl_wifi_status != NULL) {
                 char ip_data[20]={0};
                 // IP address in the payload so display
                 snprintf(ip_data,sizeof(ip_data),"%s",(const char*)lv_msg_get_payload(m));
@@ -1099,7 +1451,7 @@ static void status_change_cb(void * s, lv_msg_t *m)
             // Shows different status during OTA update
             char ota_data[150] = {0};
             snprintf(ota_data,sizeof(ota_data),"%s",(const char*)lv_msg_get_payload(m));
-            lv_label_set_text(lbl_update_status, ota_data);
+            lv_label_set_text_changed(lbl_update_status, ota_data);
         }
         break;
         case MSG_SDCARD_STATUS:
@@ -1123,9 +1475,9 @@ static void status_change_cb(void * s, lv_msg_t *m)
         case MSG_DEVICE_INFO:
         {
             ESP_LOGW(TAG,"[%d] MSG_DEVICE_INFO",msg_id);
-            char devinfo_data[300] = {0};
+            char devinfo_data[1024] = {0};
             snprintf(devinfo_data,sizeof(devinfo_data),"%s",(const char*)lv_msg_get_payload(m));
-            lv_label_set_text(lbl_device_info,devinfo_data);
+            lv_label_set_text_changed(lbl_device_info,devinfo_data);
         }
         break;
     }
@@ -1133,31 +1485,51 @@ static void status_change_cb(void * s, lv_msg_t *m)
 
 static void lv_update_battery(uint batval)
 {
-    if (batval < 20)
-    {
-        lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_RED));
-        lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_EMPTY);
-    }
-    else if (batval < 50)
-    {
-        lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_RED));
-        lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_1);
-    }
-    else if (batval < 70)
-    {
-        lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_DEEP_ORANGE));
-        lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_2);
+    // Icon has 5 levels - skip if the level didn't change
+    int level = batval < 20 ? 0 : batval < 50 ? 1 : batval < 70 ? 2 : batval < 90 ? 3 : 4;
+    if (level == battery_rendered_level) {
+        ui_state_stats.redraws_avoided++;
+        return;
     }
-    else if (batval < 90)
+    battery_rendered_level = level;
+
+    switch (level)
     {
-        lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_GREEN));
-        lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_3);
+        case 0:
+            lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_RED));
+            lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_EMPTY);
+            break;
+        case 1:
+            lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_RED));
+            lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_1);
+            break;
+        case 2:
+            lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_DEEP_ORANGE));
+            lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_2);
+            break;
+        case 3:
+            lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_GREEN));
+            lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_3);
+            break;
+        default:
+            lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_GREEN));
+            lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_FULL);
+            break;
     }
-    else
-    {
-        lv_style_set_text_color(&style_battery, lv_palette_main(LV_PALETTE_GREEN));
-        lv_label_set_text(icon_battery, LV_SYMBOL_BATTERY_FULL);
+}
+
+// lv_label_set_text() always invalidates the label, even with the same text
+static bool lv_label_set_text_changed(lv_obj_t *label, const char *text)
+{
+    if (label == NULL) return false;    // page not built or evicted
+
+    const char *current = lv_label_get_text(label);
+    if (current != NULL && strcmp(current, text) == 0) {
+        ui_state_stats.redraws_avoided++;
+        return false;
     }
+    lv_label_set_text(label, text);
+    return true;
 }
 
 /********************** ANIMATIONS *********************/
@@ -0,0 +1,277 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Image assets in PSRAM
+    LVGL reads "F:/..." / "S:/..." .bin images through lv_fs on every draw
+    (no fs or image cache configured), so a wallpaper behind a scrolling
+    page keeps hitting SPIFFS. Here the whole file is read once into PSRAM
+    and handed to LVGL as a variable image (lv_img_dsc_t), which LVGL draws
+    straight from memory.
+
+    asset_acquire() returns an image source for lv_img_set_src() or styles
+    and holds a reference, asset_release() drops it. Entries nobody holds
+    stay cached and are evicted least recently used first when the budget
+    is exceeded - referenced ones never, LVGL keeps pointing at them.
+    Without PSRAM or with the cache disabled the path itself is returned.
+*/
+
+#ifndef TUX_HELPER_ASSETS_H_
+#define TUX_HELPER_ASSETS_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define ASSET_PATH_LEN 40
+
+typedef struct {
+    char path[ASSET_PATH_LEN];
+    lv_img_dsc_t dsc;
+    uint8_t *buf;               // PSRAM copy of the file, NULL for built-in images
+    uint32_t size;
+    uint32_t last_use;          // LRU clock
+    uint16_t refs;
+    bool builtin;
+} asset_entry_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;            // read from the file system
+    uint32_t fallbacks;         // not cached - path handed to LVGL
+    uint32_t evictions;
+    uint32_t prefetches;
+    uint64_t load_us;           // total time spent on misses
+    uint32_t load_us_max;
+    uint32_t bytes;             // cached now
+    uint32_t bytes_peak;
+} asset_stats_t;
+
+static asset_entry_t assets[CONFIG_TUX_ASSET_SLOTS];
+static asset_stats_t asset_stats;
+static uint32_t asset_clock = 0;
+static SemaphoreHandle_t asset_lock = NULL;
+
+static void asset_init()
+{
+    if (asset_lock == NULL) asset_lock = xSemaphoreCreateMutex();
+}
+
+// Caller holds asset_lock
+static asset_entry_t *asset_find(const char *path)
+{
+    for (int i = 0; i < CONFIG_TUX_ASSET_SLOTS; i++) {
+        if (assets[i].path[0] && strcmp(assets[i].path, path) == 0) return &assets[i];
+    }
+    return NULL;
+}
+
+// Caller holds asset_lock - frees unreferenced entries, oldest first, until size fits
+static asset_entry_t *asset_make_room(uint32_t size)
+{
+    while (true) {
+        asset_entry_t *free_slot = NULL, *lru = NULL;
+        for (int i = 0; i < CONFIG_TUX_ASSET_SLOTS; i++) {
+            asset_entry_t *e = &assets[i];
+            if (e->path[0] == 0) { if (!free_slot) free_slot = e; continue; }
+            if (e->refs == 0 && !e->builtin && (!lru || e->last_use < lru->last_use)) lru = e;
+        }
+        if (free_slot && asset_stats.bytes + size <= CONFIG_TUX_ASSET_BUDGET_KB * 1024) return free_slot;
+        if (lru == NULL) return NULL;   // everything left is in use
+
+        ESP_LOGD(TAG, "Asset evicted %s (%" PRIu32 " bytes)", lru->path, lru->size);
+        asset_stats.bytes -= lru->size;
+        asset_stats.evictions++;
+        heap_caps_free(lru->buf);
+        memset(lru, 0, sizeof(*lru));
+    }
+}
+
+// "F:/bg/x.bin" => "/spiffs/bg/x.bin"
+static bool asset_file_name(const char *path, char *out, size_t len)
+{
+    if (path[0] == LV_FS_POSIX_LETTER && path[1] == ':') snprintf(out, len, "%s%s", LV_FS_POSIX_PATH, path + 2);
+    else if (path[0] == LV_FS_STDIO_LETTER && path[1] == ':') snprintf(out, len, "%s%s", LV_FS_STDIO_PATH, path + 2);
+    else return false;
+    return true;
+}
+
+// Any task, no LVGL calls. Returns a PSRAM buffer with the whole .bin file
+static uint8_t *asset_read(const char *path, uint32_t *size)
+{
+    char file_name[ASSET_PATH_LEN + 16];
+    struct stat st;
+    if (!asset_file_name(path, file_name, sizeof(file_name)) || stat(file_name, &st) != 0) return NULL;
+    if (st.st_size <= (off_t)sizeof(lv_img_header_t)) return NULL;
+
+    uint8_t *buf = (uint8_t *)heap_caps_malloc(st.st_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buf == NULL) return NULL;
+
+    FILE *f = fopen(file_name, "rb");
+    bool ok = f && fread(buf, 1, st.st_size, f) == (size_t)st.st_size;
+    if (f) fclose(f);
+    if (!ok) {
+        heap_caps_free(buf);
+        return NULL;
+    }
+    *size = st.st_size;
+    return buf;
+}
+
+/*
+    Cached entry for path, read from the file system if needed.
+    ref - take a reference. NULL if it can't be cached.
+*/
+static asset_entry_t *asset_load(const char *path, bool ref)
+{
+#if defined(CONFIG_TUX_ASSET_CACHE)
+    if (asset_lock == NULL || strlen(path) >= ASSET_PATH_LEN) return NULL;
+
+    xSemaphoreTake(asset_lock, portMAX_DELAY);
+    asset_entry_t *e = asset_find(path);
+    if (e) {
+        asset_stats.hits++;
+        e->last_use = ++asset_clock;
+        if (ref) e->refs++;
+        xSemaphoreGive(asset_lock);
+        return e;
+    }
+    xSemaphoreGive(asset_lock);
+
+    // File read without the lock, other lookups go on meanwhile
+    int64_t start = esp_timer_get_time();
+    uint32_t size = 0;
+    uint8_t *buf = asset_read(path, &size);
+    uint32_t elapsed = esp_timer_get_time() - start;
+    if (buf == NULL) return NULL;
+
+    xSemaphoreTake(asset_lock, portMAX_DELAY);
+    e = asset_find(path);               // someone else was quicker
+    if (e == NULL && (e = asset_make_room(size)) != NULL) {
+        strlcpy(e->path, path, sizeof(e->path));
+        memcpy(&e->dsc.header, buf, sizeof(lv_img_header_t));
+        e->dsc.data = buf + sizeof(lv_img_header_t);
+        e->dsc.data_size = size - sizeof(lv_img_header_t);
+        e->buf = buf;
+        e->size = size;
+        buf = NULL;
+
+        asset_stats.misses++;
+        asset_stats.load_us += elapsed;
+        if (elapsed > asset_stats.load_us_max) asset_stats.load_us_max = elapsed;
+        asset_stats.bytes += size;
+        if (asset_stats.bytes > asset_stats.bytes_peak) asset_stats.bytes_peak = asset_stats.bytes;
+        ESP_LOGD(TAG, "Asset loaded %s (%" PRIu32 " bytes) in %" PRIu32 "us", path, size, elapsed);
+    }
+    if (e) {
+        e->last_use = ++asset_clock;
+        if (ref) e->refs++;
+    }
+    xSemaphoreGive(asset_lock);
+
+    if (buf) heap_caps_free(buf);       // duplicate or over budget
+    return e;
+#else
+    return NULL;
+#endif
+}
+
+// Compiled-in image under a name, so callers don't care where it lives
+static void asset_register(const char *name, const lv_img_dsc_t *dsc)
+{
+    if (asset_lock == NULL || strlen(name) >= ASSET_PATH_LEN) return;
+    xSemaphoreTake(asset_lock, portMAX_DELAY);
+    asset_entry_t *e = asset_find(name);
+    if (e == NULL) e = asset_make_room(0);
+    if (e) {
+        strlcpy(e->path, name, sizeof(e->path));
+        e->dsc = *dsc;
+        e->builtin = true;
+    }
+    xSemaphoreGive(asset_lock);
+}
+
+// Image source for lv_img_set_src() / lv_style_set_bg_img_src(), holds a reference
+static const void *asset_acquire(const char *path)
+{
+    asset_entry_t *e = asset_load(path, true);
+    if (e) return &e->dsc;
+    asset_stats.fallbacks++;
+    return path;
+}
+
+static void asset_release(const void *src)
+{
+    if (asset_lock == NULL) return;
+    xSemaphoreTake(asset_lock, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_TUX_ASSET_SLOTS; i++) {
+        if (&assets[i].dsc == src && assets[i].refs) {
+            assets[i].refs--;
+            break;
+        }
+    }
+    xSemaphoreGive(asset_lock);
+}
+
+static void asset_img_delete_cb(lv_event_t *e)
+{
+    asset_release(lv_event_get_user_data(e));
+}
+
+// lv_img_set_src() with a cached image, released when the image object goes away
+static void asset_img_set_src(lv_obj_t *img, const char *path)
+{
+    const void *src = asset_acquire(path);
+    lv_img_set_src(img, src);
+    if (src != path) lv_obj_add_event_cb(img, asset_img_delete_cb, LV_EVENT_DELETE, (void *)src);
+}
+
+static void asset_prefetch_job(void *arg)
+{
+    asset_load((const char *)arg, false);
+}
+
+// Load into the cache on a worker, path must outlive the job (string literal)
+static void asset_prefetch(const char *path)
+{
+#if defined(CONFIG_TUX_ASSET_CACHE)
+    asset_stats.prefetches++;
+    worker_submit("asset_prefetch", asset_prefetch_job, (void *)path);
+#endif
+}
+
+static void asset_report()
+{
+    uint32_t misses = asset_stats.misses;
+    ESP_LOGI(TAG, "assets hits:%" PRIu32 " misses:%" PRIu32 " fallbacks:%" PRIu32 " evictions:%" PRIu32
+                  " load avg:%" PRIu32 "us max:%" PRIu32 "us, %" PRIu32 "KB cached (peak %" PRIu32 "KB) of %dKB",
+                asset_stats.hits, misses, asset_stats.fallbacks, asset_stats.evictions,
+                misses ? (uint32_t)(asset_stats.load_us / misses) : 0, asset_stats.load_us_max,
+                asset_stats.bytes / 1024, asset_stats.bytes_peak / 1024, CONFIG_TUX_ASSET_BUDGET_KB);
+}
+
+#endif // TUX_HELPER_ASSETS_H_
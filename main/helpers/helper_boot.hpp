@@ -0,0 +1,167 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Boot timeline
+    Startup phases are timestamped (esp_timer, so time since the chip came
+    out of reset minus the bootloader) with the core they ran on. Phases
+    that don't depend on each other run as short lived tasks on the other
+    core while app_main brings up the display, boot_wait() joins them.
+    The timeline is printed over serial and shown on the device info page.
+*/
+
+#ifndef TUX_HELPER_BOOT_H_
+#define TUX_HELPER_BOOT_H_
+
+#include <atomic>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+
+#define BOOT_MAX_PHASES 20
+#define BOOT_MAX_JOBS   4
+
+typedef struct {
+    const char *name;
+    int64_t start_us;
+    int64_t end_us;     // 0 - still running
+    uint8_t core;
+} boot_phase_t;
+
+typedef void (*boot_fn_t)(void);
+
+typedef struct {
+    const char *name;
+    boot_fn_t fn;
+    EventBits_t bit;
+} boot_job_t;
+
+static boot_phase_t boot_phases[BOOT_MAX_PHASES];
+static std::atomic<int> boot_phase_count(0);
+static EventGroupHandle_t boot_events = NULL;
+static boot_job_t boot_jobs[BOOT_MAX_JOBS];
+static int boot_job_count = 0;
+static int64_t boot_splash_us = 0;
+
+static int boot_begin(const char *name)
+{
+    int id = boot_phase_count.fetch_add(1);
+    if (id >= BOOT_MAX_PHASES) return -1;
+    boot_phases[id].name = name;
+    boot_phases[id].core = xPortGetCoreID();
+    boot_phases[id].end_us = 0;
+    boot_phases[id].start_us = esp_timer_get_time();
+    return id;
+}
+
+static void boot_end(int id)
+{
+    if (id < 0 || id >= BOOT_MAX_PHASES) return;
+    boot_phases[id].end_us = esp_timer_get_time();
+}
+
+// First frame is on the panel
+static void boot_splash_shown()
+{
+    boot_splash_us = esp_timer_get_time();
+    if (boot_splash_us > CONFIG_TUX_BOOT_SPLASH_TARGET_MS * 1000LL)
+        ESP_LOGW(TAG, "Splash shown at %" PRId64 "ms, target %dms",
+                    boot_splash_us / 1000, CONFIG_TUX_BOOT_SPLASH_TARGET_MS);
+}
+
+static void boot_job_task(void *arg)
+{
+    boot_job_t *job = (boot_job_t *)arg;
+    int id = boot_begin(job->name);
+    job->fn();
+    boot_end(id);
+    xEventGroupSetBits(boot_events, job->bit);
+    vTaskDelete(NULL);
+}
+
+/*
+    Run a boot phase - on the other core when parallel, else right here.
+    bit is set once it's done either way, see boot_wait().
+*/
+static void boot_run(const char *name, boot_fn_t fn, EventBits_t bit, bool parallel = true)
+{
+    if (boot_events == NULL) boot_events = xEventGroupCreate();
+
+#if defined(CONFIG_TUX_BOOT_PARALLEL) && CONFIG_FREERTOS_UNICORE == 0
+    if (parallel && boot_job_count < BOOT_MAX_JOBS) {
+        boot_job_t *job = &boot_jobs[boot_job_count++];
+        job->name = name;
+        job->fn = fn;
+        job->bit = bit;
+        // app_main runs on core 0
+        if (xTaskCreatePinnedToCore(boot_job_task, name, 1024 * 8, job, 5, NULL, 1) == pdPASS) return;
+        boot_job_count--;
+    }
+#endif
+
+    int id = boot_begin(name);
+    fn();
+    boot_end(id);
+    xEventGroupSetBits(boot_events, bit);
+}
+
+static void boot_wait(EventBits_t bits)
+{
+    if (boot_events == NULL) return;
+    int id = boot_begin("wait");
+    xEventGroupWaitBits(boot_events, bits, pdFALSE, pdTRUE, portMAX_DELAY);
+    boot_end(id);
+}
+
+// "name start-end core" per phase, in ms since reset
+static std::string boot_timeline()
+{
+    char line[64];
+    std::string s;
+    int count = boot_phase_count.load();
+    if (count > BOOT_MAX_PHASES) count = BOOT_MAX_PHASES;
+
+    for (int i = 0; i < count; i++) {
+        const boot_phase_t &p = boot_phases[i];
+        if (p.end_us == 0) continue;
+        snprintf(line, sizeof(line), "%-10s %5" PRId64 "-%-5" PRId64 "ms c%d\n",
+                    p.name, p.start_us / 1000, p.end_us / 1000, p.core);
+        s += line;
+    }
+    if (boot_splash_us) {
+        snprintf(line, sizeof(line), "Splash at %" PRId64 "ms (target %dms)\n",
+                    boot_splash_us / 1000, CONFIG_TUX_BOOT_SPLASH_TARGET_MS);
+        s += line;
+    }
+    return s;
+}
+
+static void boot_report()
+{
+    ESP_LOGI(TAG, "Boot timeline:\n%s", boot_timeline().c_str());
+}
+
+#endif // TUX_HELPER_BOOT_H_
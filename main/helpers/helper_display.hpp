@@ -25,6 +25,11 @@ SOFTWARE.
 
 #include "lv_conf.h"
 #include <lvgl.h>
+#include "driver/gpio.h"
+#include "helper_perf.hpp"
+#include "helper_ui_queue.hpp"
+#include "helper_ui_state.hpp"
+#include "helper_worker.hpp"
 
 
 #define LV_TICK_PERIOD_MS 1
@@ -58,11 +63,29 @@ SOFTWARE.
 static const uint16_t screenWidth = TFT_WIDTH;
 static const uint16_t screenHeight = TFT_HEIGHT;
 
-#define BUFF_SIZE 40
-#define LVGL_DOUBLE_BUFFER
+/*** LVGL draw buffer strategy - menuconfig => Performance Config ***/
+#if defined(CONFIG_TUX_DRAW_BUF_PSRAM_FULL)
+#define LVGL_DIRECT_MODE        // single full-frame buffer in PSRAM
+#else
+#define LVGL_DOUBLE_BUFFER      // two partial buffers in internal DMA RAM
+#endif
+
+#if defined(CONFIG_TUX_DRAW_BUF_INTERNAL)
+#define BUFF_SIZE CONFIG_TUX_DRAW_BUF_LINES
+#else
+#define BUFF_SIZE 40            // fallback if adaptive sizing fails
+#endif
+#define BUFF_MIN_LINES 10       // adaptive sizing asks for at least this much
+#define BUFF_FLOOR_LINES 4      // below this LVGL spends more time per flush than rendering
 
 static lv_disp_draw_buf_t draw_buf;
 
+// What got allocated, printed at boot and by the UI benchmark
+static const char *draw_buf_mode;
+static uint32_t draw_buf_lines;
+static uint32_t draw_buf_bytes;     // per buffer
+static uint8_t draw_buf_count;
+
 static lv_disp_t *disp;
 static lv_theme_t *theme_current;
 static lv_color_t bg_theme_color;
@@ -74,6 +97,7 @@ static LGFX lcd; // declare display variable
  * you should lock on the very same semaphore! */
 static SemaphoreHandle_t xGuiSemaphore = NULL;
 static TaskHandle_t g_lvgl_task_handle;
+static lv_indev_t *indev_touch;
 
 static void gui_task(void *args);
 
@@ -81,6 +105,87 @@ static void gui_task(void *args);
 void display_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p);
 void touchpad_read(lv_indev_drv_t *indev_driver, lv_indev_data_t *data);
 static void lv_tick_task(void *arg);
+#if defined(CONFIG_TUX_FLUSH_ASYNC)
+static void flush_wait_cb(lv_disp_drv_t *disp_drv);
+static esp_err_t flush_task_init();
+#endif
+
+// Number of lines that fit into the free DMA capable heap, keeping a reserve for other drivers
+static uint32_t lv_draw_buf_adaptive_lines(uint8_t count)
+{
+    size_t free_dma = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA);
+    size_t reserve = 0;
+#if defined(CONFIG_TUX_DRAW_BUF_ADAPTIVE)
+    reserve = CONFIG_TUX_DRAW_BUF_DMA_RESERVE * 1024;
+#endif
+    size_t usable = (free_dma > reserve) ? (free_dma - reserve) / count : 0;
+    if (usable > largest) usable = largest;
+
+    uint32_t lines = usable / (screenWidth * sizeof(lv_color_t));
+    if (lines > screenHeight / 2) lines = screenHeight / 2;     // more gives nothing back
+    ESP_LOGI(TAG, "Adaptive draw buffer: free DMA %u / largest block %u => %" PRIu32 " lines",
+                free_dma, largest, lines);
+    return lines;
+}
+
+static esp_err_t lv_draw_buf_setup()
+{
+    lv_color_t *buf1 = NULL;
+    lv_color_t *buf2 = NULL;
+
+#if defined(LVGL_DIRECT_MODE)
+    // Full frame, both orientations need the same amount of pixels
+    draw_buf_mode = "psram-full";
+    draw_buf_lines = screenHeight;
+    draw_buf_count = 1;
+    buf1 = (lv_color_t *)heap_caps_malloc(screenWidth * screenHeight * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+#else
+    draw_buf_count = 2;
+#if defined(CONFIG_TUX_DRAW_BUF_ADAPTIVE)
+    draw_buf_mode = "adaptive";
+    draw_buf_lines = lv_draw_buf_adaptive_lines(draw_buf_count);
+    if (draw_buf_lines < BUFF_MIN_LINES) draw_buf_lines = BUFF_MIN_LINES;   // try anyway, stepped down below
+#else
+    draw_buf_mode = "internal";
+    draw_buf_lines = BUFF_SIZE;
+#endif
+    // Step down until the buffer fits, fail only below BUFF_FLOOR_LINES
+    while (1) {
+        buf1 = (lv_color_t *)heap_caps_malloc(screenWidth * draw_buf_lines * sizeof(lv_color_t), MALLOC_CAP_DMA);
+        if (buf1 || draw_buf_lines <= BUFF_FLOOR_LINES) break;
+        uint32_t lines = draw_buf_lines * 3 / 4;
+        draw_buf_lines = (lines < BUFF_FLOOR_LINES) ? BUFF_FLOOR_LINES : lines;
+        ESP_LOGW(TAG, "Draw buffer allocation failed, retrying with %" PRIu32 " lines", draw_buf_lines);
+    }
+    if (buf1) buf2 = (lv_color_t *)heap_caps_malloc(screenWidth * draw_buf_lines * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    if (buf1 && !buf2) draw_buf_count = 1;  // still usable with single buffer
+#endif
+
+    if (!buf1) return ESP_FAIL;
+
+    draw_buf_bytes = screenWidth * draw_buf_lines * sizeof(lv_color_t);
+    lv_disp_draw_buf_init(&draw_buf, buf1, buf2, screenWidth * draw_buf_lines);
+
+    ESP_LOGW(TAG, "Draw buffer [%s] %d x %" PRIu32 " bytes (%" PRIu32 " lines) - free internal:%u psram:%u",
+                draw_buf_mode, draw_buf_count, draw_buf_bytes, draw_buf_lines,
+                heap_caps_get_free_size(MALLOC_CAP_INTERNAL), heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    return ESP_OK;
+}
+
+static void lv_draw_buf_report()
+{
+    ESP_LOGW(TAG, "Draw buffer [%s] %d x %" PRIu32 " bytes (%" PRIu32 " lines)",
+                draw_buf_mode, draw_buf_count, draw_buf_bytes, draw_buf_lines);
+}
+
+#if defined(LVGL_DIRECT_MODE)
+// No sw_rotate in direct mode, rotate the panel itself (lcd.setRotation(2) is portrait)
+static void display_update_cb(lv_disp_drv_t *drv)
+{
+    lcd.setRotation((2 + drv->rotated) & 0x03);
+}
+#endif
 
 
 esp_err_t lv_display_init()
@@ -94,19 +199,11 @@ esp_err_t lv_display_init()
     //lcd.fillScreen(TFT_BLACK);
 
     /* LVGL : Setting up buffer to use for display */
-#if defined(LVGL_DOUBLE_BUFFER)
-    // EXT_RAM_BSS_ATTR lv_color_t * buf1 = (lv_color_t *)malloc(screenWidth * BUFF_SIZE * sizeof(lv_color_t));
-    // EXT_RAM_BSS_ATTR lv_color_t * buf2 = (lv_color_t *)malloc(screenWidth * BUFF_SIZE * sizeof(lv_color_t));
-
-    lv_color_t * buf1 = (lv_color_t *)heap_caps_malloc(screenWidth * BUFF_SIZE * sizeof(lv_color_t),MALLOC_CAP_DMA);
-    lv_color_t * buf2 = (lv_color_t *)heap_caps_malloc(screenWidth * BUFF_SIZE * sizeof(lv_color_t),MALLOC_CAP_DMA);
-
-    lv_disp_draw_buf_init(&draw_buf, buf1, buf2, screenWidth * BUFF_SIZE);    
-#else
-    // EXT_RAM_BSS_ATTR lv_color_t * buf1 = (lv_color_t *)malloc(screenWidth * BUFF_SIZE * sizeof(lv_color_t));
-    lv_color_t * buf1 = (lv_color_t *)heap_caps_malloc(screenWidth * BUFF_SIZE * sizeof(lv_color_t),MALLOC_CAP_DMA);
-    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, screenWidth * BUFF_SIZE);
-#endif
+    if (lv_draw_buf_setup() != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Allocating LVGL draw buffers failed");
+        return ESP_FAIL;
+    }
 
     /*** LVGL : Setup & Initialize the display device driver ***/
     static lv_disp_drv_t disp_drv;
@@ -115,7 +212,25 @@ esp_err_t lv_display_init()
     disp_drv.ver_res = screenHeight;
     disp_drv.flush_cb = display_flush;
     disp_drv.draw_buf = &draw_buf;
+#if defined(LVGL_DIRECT_MODE)
+    // LVGL draws straight into the full frame, rotation is done by the panel
+    disp_drv.direct_mode = 1;
+    disp_drv.sw_rotate = 0;
+    disp_drv.drv_update_cb = display_update_cb;
+#else
     disp_drv.sw_rotate = 1;
+#endif
+    disp_drv.render_start_cb = perf_render_start_cb;    // frame timing
+    disp_drv.monitor_cb = perf_monitor_cb;
+    perf_reset();
+#if defined(CONFIG_TUX_FLUSH_ASYNC)
+    disp_drv.wait_cb = flush_wait_cb;
+    if (flush_task_init() != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Create flush task for LVGL failed");
+        return ESP_FAIL;
+    }
+#endif
     disp = lv_disp_drv_register(&disp_drv);
 
     //*** LVGL : Setup & Initialize the input device driver ***
@@ -123,7 +238,7 @@ esp_err_t lv_display_init()
     lv_indev_drv_init(&indev_drv);
     indev_drv.type = LV_INDEV_TYPE_POINTER;
     indev_drv.read_cb = touchpad_read;
-    lv_indev_drv_register(&indev_drv);
+    indev_touch = lv_indev_drv_register(&indev_drv);
 
     /* Create and start a periodic timer interrupt to call lv_tick_inc */
     const esp_timer_create_args_t lv_periodic_timer_args = {
@@ -170,12 +285,100 @@ esp_err_t lv_display_init()
     return ESP_OK;
 }
 
-// Display callback to flush the buffer to screen
-void display_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p)
+#if defined(CONFIG_TUX_FLUSH_COALESCE)
+/*
+    Flush coalescing
+    All areas of one refresh cycle are pushed inside a single bus transaction.
+    The address window is opened down to the bottom of the panel, so when the
+    next area continues the previous one (same columns, next row) the panel
+    write pointer is already in place and the strip is merged into the running
+    transfer without a new setAddrWindow.
+*/
+static bool flush_in_transaction = false;
+static lv_area_t flush_prev_area;
+
+static inline bool flush_area_continues(const lv_area_t *area)
+{
+    return flush_prev_area.x1 == area->x1 && flush_prev_area.x2 == area->x2 &&
+           flush_prev_area.y2 + 1 == area->y1;
+}
+#endif
+
+#if defined(CONFIG_TUX_FLUSH_ASYNC)
+/*
+    LovyanGFX has no DMA done interrupt to hook, lcd.waitDMA() spins on the
+    bus. The flush task sleeps for the expected transfer time instead (bytes x
+    time per byte learned from earlier transfers) on a one-shot esp_timer and
+    only checks the rest with waitDMA(). The estimate is kept a little short,
+    waking early costs a short spin, waking late costs frame time.
+*/
+#define FLUSH_SLEEP_MIN_US  200         // shorter transfers are not worth a timer
+static TaskHandle_t flush_task_handle;
+static esp_timer_handle_t flush_dma_timer;
+static uint32_t flush_ns_per_byte;      // 0 until the first transfer was measured
+
+static void flush_dma_timer_cb(void *arg)
+{
+    xTaskNotifyGive(flush_task_handle);
+}
+
+static void flush_wait_dma(uint32_t bytes, int64_t started)
+{
+    bool slept = false;
+    if (flush_ns_per_byte && lcd.dmaBusy()) {
+        int64_t remaining = (int64_t)bytes * flush_ns_per_byte / 1000 - (esp_timer_get_time() - started);
+        if (remaining > FLUSH_SLEEP_MIN_US && esp_timer_start_once(flush_dma_timer, remaining) == ESP_OK) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+            slept = true;
+        }
+    }
+
+    bool busy = lcd.dmaBusy();
+    lcd.waitDMA();
+    uint32_t ns = (uint32_t)((esp_timer_get_time() - started) * 1000 / bytes);
+    if (!flush_ns_per_byte || (busy && ns > flush_ns_per_byte)) {
+        flush_ns_per_byte = ns;                             // measured up to the real end of the transfer
+    } else if (slept && !busy) {
+        flush_ns_per_byte -= flush_ns_per_byte / 16 + 1;    // overslept, shorten the estimate
+    }
+}
+#else
+static inline void flush_wait_dma(uint32_t bytes, int64_t started)
+{
+    lcd.waitDMA();
+}
+#endif
+
+// Push one rendered area to the panel, returns when the DMA transfer is done
+static void flush_push_area(const lv_area_t *area, lv_color_t *color_p, bool last)
 {
     uint32_t w = (area->x2 - area->x1 + 1);
     uint32_t h = (area->y2 - area->y1 + 1);
+    uint32_t bytes = w * h * sizeof(lv_color_t);
+    int64_t flush_start = esp_timer_get_time();
+    int64_t blocked_start = perf_flush_begin(flush_start);
+
+#if defined(CONFIG_TUX_FLUSH_COALESCE)
+    bool merged = false;
+    if (!flush_in_transaction) {
+        lcd.startWrite();
+        flush_in_transaction = true;
+        lcd.setAddrWindow(area->x1, area->y1, w, lcd.height() - area->y1);
+    } else if (flush_area_continues(area)) {
+        merged = true;      // write pointer is already at area->y1
+    } else {
+        lcd.setAddrWindow(area->x1, area->y1, w, lcd.height() - area->y1);
+    }
+    lcd.pushPixelsDMA((lgfx::swap565_t *)&color_p->full, w * h);
+    flush_wait_dma(bytes, flush_start);     // LVGL reuses the buffer once flush is ready
+    flush_prev_area = *area;
 
+    if (last) {
+        lcd.endWrite();
+        flush_in_transaction = false;
+    }
+    perf_flush_merged(merged);
+#else
     /* Without DMA */
     // lcd.startWrite();
     // lcd.setAddrWindow(area->x1, area->y1, w, h);
@@ -183,13 +386,98 @@ void display_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color
     // lcd.endWrite();
 
     /* With DMA */
-    // TODO: Yet to do performance test
     lcd.startWrite();
     lcd.setAddrWindow(area->x1, area->y1, w, h);
-    lcd.pushImageDMA(area->x1, area->y1, area->x2 - area->x1 + 1, area->y2 - area->y1 + 1, (lgfx::swap565_t *)&color_p->full);
+    lcd.pushPixelsDMA((lgfx::swap565_t *)&color_p->full, w * h);
+    flush_wait_dma(bytes, flush_start);
     lcd.endWrite();
+    perf_flush_merged(false);
+#endif
+
+    perf_flush_area(w * h, bytes, flush_start, blocked_start);
+}
+
+#if defined(CONFIG_TUX_FLUSH_ASYNC)
+/*
+    Asynchronous flush
+    display_flush() only queues the area and returns, so LVGL can render the
+    next area into the other draw buffer while this one is still on the bus.
+    flush_task pushes the area and signals LVGL with lv_disp_flush_ready()
+    once the DMA transfer is complete. It runs on the other core than
+    gui_task and sleeps while the DMA runs (flush_wait_dma).
+*/
+typedef struct {
+    lv_disp_drv_t *drv;
+    lv_area_t area;
+    lv_color_t *color_p;
+    bool last;                  // last area of the refresh cycle
+} flush_job_t;
+
+static QueueHandle_t flush_queue;
+static SemaphoreHandle_t flush_done;    // given after every completed area
+
+static void flush_task(void *args)
+{
+    flush_job_t job;
+    while (1) {
+        if (xQueueReceive(flush_queue, &job, portMAX_DELAY) == pdTRUE) {
+            flush_push_area(&job.area, job.color_p, job.last);
+            lv_disp_flush_ready(job.drv);     // completion hook
+            xSemaphoreGive(flush_done);
+        }
+    }
+}
+
+// LVGL needs a buffer which is still being flushed - sleep until the flush task gives flush_done.
+// LVGL calls this in a loop until the buffer is free, a give left from an earlier area just
+// costs one more round.
+static void flush_wait_cb(lv_disp_drv_t *disp_drv)
+{
+    int64_t wait_start = esp_timer_get_time();
+    perf_flush_wait_begin(wait_start);
+    xSemaphoreTake(flush_done, pdMS_TO_TICKS(20));
+    perf_flush_wait_end(wait_start);
+}
+
+static esp_err_t flush_task_init()
+{
+    flush_queue = xQueueCreate(2, sizeof(flush_job_t));     // one per draw buffer
+    flush_done = xSemaphoreCreateBinary();
+    if (!flush_queue || !flush_done) return ESP_FAIL;
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = &flush_dma_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "flush_dma",
+        .skip_unhandled_events = false
+        };
+    if (esp_timer_create(&timer_args, &flush_dma_timer) != ESP_OK) return ESP_FAIL;
+
+    // Other core than gui_task (core 1), so rendering goes on while an area is on the bus.
+    // Single core => higher priority than gui_task, it only starts the DMA and sleeps.
+    int err = xTaskCreatePinnedToCore(flush_task, "lv flush", 1024 * 3, NULL, 4, &flush_task_handle, 0);
+    return (err == pdPASS) ? ESP_OK : ESP_FAIL;
+}
+#endif
+
+// Display callback to flush the buffer to screen
+void display_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p)
+{
+#if defined(LVGL_DIRECT_MODE)
+    // color_p is the whole frame - push complete rows so the data is contiguous
+    lv_area_t rows = { 0, area->y1, (lv_coord_t)(disp->hor_res - 1), area->y2 };
+    color_p += area->y1 * disp->hor_res;
+    area = &rows;
+#endif
 
+#if defined(CONFIG_TUX_FLUSH_ASYNC)
+    flush_job_t job = { disp, *area, color_p, lv_disp_flush_is_last(disp) };
+    xQueueSend(flush_queue, &job, portMAX_DELAY);
+#else
+    flush_push_area(area, color_p, lv_disp_flush_is_last(disp));
     lv_disp_flush_ready(disp);
+#endif
 }
 
 /* Setting up tick task for lvgl */
@@ -199,26 +487,122 @@ static void lv_tick_task(void *arg)
     lv_tick_inc(LV_TICK_PERIOD_MS);
 }
 
+#if defined(CONFIG_TUX_GUI_EVENT_DRIVEN)
+/*
+    Event driven GUI task
+    gui_task sleeps until the next LVGL timer is due (lv_timer_handler() tells us)
+    and is woken early by the touch controller interrupt or gui_task_wake()
+    when a UI message gets posted. While the panel is not touched the indev
+    read timer is paused so it doesn't keep the task polling every 30ms.
+*/
+static volatile bool touch_irq_pending = false;
+static bool touch_irq_enabled = false;
+static uint8_t touch_idle_reads = 0;
+
+// Wake the GUI task from another task - call after posting something for the UI
+static void gui_task_wake()
+{
+    if (g_lvgl_task_handle) xTaskNotifyGive(g_lvgl_task_handle);
+}
+
+static void IRAM_ATTR touch_isr_handler(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    touch_irq_pending = true;
+    vTaskNotifyGiveFromISR(g_lvgl_task_handle, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+static void touch_irq_init()
+{
+    if (lcd.touch() == nullptr) return;
+    int pin_int = lcd.touch()->config().pin_int;
+    if (pin_int < 0) return;    // no interrupt line, keep polling
+
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return;  // already installed is fine
+
+    gpio_set_intr_type((gpio_num_t)pin_int, GPIO_INTR_NEGEDGE);
+    if (gpio_isr_handler_add((gpio_num_t)pin_int, touch_isr_handler, NULL) == ESP_OK) {
+        touch_irq_enabled = true;
+        ESP_LOGI(TAG, "Touch interrupt on GPIO%d wakes the GUI task", pin_int);
+    }
+}
+#else
+static void gui_task_wake() { }
+#endif
+
 static void gui_task(void *args)
 {
     ESP_LOGI(TAG, "Start to run LVGL");
+#if defined(CONFIG_TUX_GUI_EVENT_DRIVEN)
+    touch_irq_init();
+    uint32_t sleep_ms = 0;
+#endif
+#if CONFIG_TUX_GUI_STATS_INTERVAL > 0
+    gui_stats.since = esp_timer_get_time();
+    int64_t report_at = gui_stats.since + CONFIG_TUX_GUI_STATS_INTERVAL * 1000000LL;
+#endif
+
     while (1) {
+        int64_t idle_start = esp_timer_get_time();
+#if defined(CONFIG_TUX_GUI_EVENT_DRIVEN)
+        // Sleep till the next timer deadline, touch or a posted message wakes us earlier
+        // at least one tick, so a timer that is always ready can't starve lower priority tasks
+        TickType_t ticks = pdMS_TO_TICKS(sleep_ms);
+        if (ticks == 0) ticks = 1;
+        bool woken = ulTaskNotifyTake(pdTRUE, ticks) > 0;
+        gui_stats_idle(esp_timer_get_time() - idle_start, woken);
+#else
         vTaskDelay(pdMS_TO_TICKS(10));
+        gui_stats_idle(esp_timer_get_time() - idle_start, false);
+#endif
 
         /* Try to take the semaphore, call lvgl related function on success */
         if (pdTRUE == xSemaphoreTake(xGuiSemaphore, portMAX_DELAY)) {
+            int64_t lock_start = esp_timer_get_time();
+            // Messages posted by other tasks since the last run
+            ui_queue_drain();
+            ui_state_drain();
+#if defined(CONFIG_TUX_GUI_EVENT_DRIVEN)
+            if (touch_irq_pending && indev_touch) {
+                // Finger down - poll the touch controller again
+                touch_irq_pending = false;
+                touch_idle_reads = 0;
+                lv_timer_resume(indev_touch->driver->read_timer);
+                lv_timer_ready(indev_touch->driver->read_timer);
+            }
+            sleep_ms = lv_timer_handler();
+            if (sleep_ms > CONFIG_TUX_GUI_MAX_SLEEP_MS) sleep_ms = CONFIG_TUX_GUI_MAX_SLEEP_MS;   // LV_NO_TIMER_READY too
+#else
             lv_task_handler();
             //lv_timer_handler_run_in_period(5); /* run lv_timer_handler() every 5ms */
+#endif
+            gui_stats_lock(esp_timer_get_time() - lock_start, true);
             xSemaphoreGive(xGuiSemaphore);
         }
+
+#if CONFIG_TUX_GUI_STATS_INTERVAL > 0
+        if (esp_timer_get_time() > report_at) {
+            gui_stats_report();
+            ui_queue_report();
+            ui_state_report();
+            worker_report();
+            report_at = esp_timer_get_time() + CONFIG_TUX_GUI_STATS_INTERVAL * 1000000LL;
+        }
+#endif
     }
 }
 
+// Lock hold time of other tasks using lvgl_acquire()/lvgl_release()
+static int64_t lvgl_lock_start;
+
 void lvgl_acquire(void)
 {
     TaskHandle_t task = xTaskGetCurrentTaskHandle();
     if (g_lvgl_task_handle != task) {
         xSemaphoreTake(xGuiSemaphore, portMAX_DELAY);
+        lvgl_lock_start = esp_timer_get_time();
     }
 }
 
@@ -226,7 +610,9 @@ void lvgl_release(void)
 {
     TaskHandle_t task = xTaskGetCurrentTaskHandle();
     if (g_lvgl_task_handle != task) {
+        gui_stats_lock(esp_timer_get_time() - lvgl_lock_start, false);
         xSemaphoreGive(xGuiSemaphore);
+        gui_task_wake();    // whatever was changed gets rendered right away
     }
 }
 
@@ -239,10 +625,19 @@ void touchpad_read(lv_indev_drv_t *indev_driver, lv_indev_data_t *data)
     if (!touched)
     {
         data->state = LV_INDEV_STATE_REL;
+#if defined(CONFIG_TUX_GUI_EVENT_DRIVEN)
+        // Finger lifted for a while - stop polling, touch interrupt resumes it
+        if (touch_irq_enabled && ++touch_idle_reads > 3) {
+            lv_timer_pause(indev_driver->read_timer);
+        }
+#endif
     }
     else
     {
         data->state = LV_INDEV_STATE_PR;
+#if defined(CONFIG_TUX_GUI_EVENT_DRIVEN)
+        touch_idle_reads = 0;
+#endif
 
         // Set the coordinates
         data->point.x = touchX;
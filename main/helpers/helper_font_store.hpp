@@ -0,0 +1,212 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Font store - LVGL binary fonts loaded from F: (SPIFFS) or S: (SD card)
+    The big fonts (7 segment clock, weather icons in several sizes) used to
+    be linked into the app as C arrays. Here they are .bin files made with
+    lv_font_conv (see fatfs/fonts/readme.txt), loaded with lv_font_load()
+    the first time a page asks for them. Files converted with compression
+    stay compressed in memory, their glyphs are unpacked once by the glyph
+    cache (helper_glyph_cache.hpp) when drawn.
+
+    font_store_acquire() returns a font and holds a reference, the fallback
+    (a linked-in font, see TUX_FONT_BUILTIN) when the file is missing.
+    font_store_release() drops it. Fonts nobody holds stay loaded and are
+    freed least recently used first once CONFIG_TUX_FONT_STORE_KB is used up.
+
+    lv_font_load() reads through lv_fs, so everything here runs with the
+    LVGL lock held - no extra locking.
+*/
+
+#ifndef TUX_HELPER_FONT_STORE_H_
+#define TUX_HELPER_FONT_STORE_H_
+
+#include <string.h>
+#include "esp_timer.h"
+
+// Linked-in copy of a font, NULL when the C arrays are left out of the build
+#if defined(CONFIG_TUX_FONTS_BUILTIN)
+#define TUX_FONT_BUILTIN(font) (&font)
+#else
+#define TUX_FONT_BUILTIN(font) NULL
+#endif
+
+#define TUX_FONT_CLOCK "F:/fonts/7seg_56.bin"
+#define TUX_FONT_WEATHER_FMT "F:/fonts/fa_weather_%d.bin"
+
+#define FONT_STORE_SLOTS 8
+#define FONT_PATH_LEN 40
+
+typedef struct {
+    char path[FONT_PATH_LEN];
+    lv_font_t *font;
+    uint32_t size;              // file size, what lv_font_load() keeps in memory
+    uint32_t last_use;
+    uint16_t refs;
+} font_entry_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t loads;
+    uint32_t fallbacks;         // file missing or no room - fallback font returned
+    uint32_t evictions;
+    uint64_t load_us;
+    uint32_t load_us_max;
+    uint32_t bytes;
+    uint32_t bytes_peak;
+} font_store_stats_t;
+
+static font_entry_t font_entries[FONT_STORE_SLOTS];
+static font_store_stats_t font_store_stats;
+static uint32_t font_store_clock = 0;
+
+static font_entry_t *font_store_find_font(const lv_font_t *font)
+{
+    for (int i = 0; i < FONT_STORE_SLOTS; i++) {
+        if (font_entries[i].font && font_entries[i].font == font) return &font_entries[i];
+    }
+    return NULL;
+}
+
+// Frees unreferenced fonts, oldest first, until size fits
+static font_entry_t *font_store_make_room(uint32_t size)
+{
+    while (true) {
+        font_entry_t *free_slot = NULL, *lru = NULL;
+        for (int i = 0; i < FONT_STORE_SLOTS; i++) {
+            font_entry_t *e = &font_entries[i];
+            if (e->font == NULL) { if (!free_slot) free_slot = e; continue; }
+            if (e->refs == 0 && (!lru || e->last_use < lru->last_use)) lru = e;
+        }
+        if (free_slot && font_store_stats.bytes + size <= CONFIG_TUX_FONT_STORE_KB * 1024) return free_slot;
+        if (lru == NULL) return NULL;
+
+        ESP_LOGD(TAG, "Font evicted %s (%" PRIu32 " bytes)", lru->path, lru->size);
+        glyph_cache_forget(lru->font);
+        lv_font_free(lru->font);
+        font_store_stats.bytes -= lru->size;
+        font_store_stats.evictions++;
+        memset(lru, 0, sizeof(*lru));
+    }
+}
+
+static uint32_t font_store_file_size(const char *path)
+{
+    lv_fs_file_t f;
+    uint32_t size = 0;
+    if (!lv_fs_is_ready(path[0]) || lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return 0;
+    if (lv_fs_seek(&f, 0, LV_FS_SEEK_END) != LV_FS_RES_OK || lv_fs_tell(&f, &size) != LV_FS_RES_OK) size = 0;
+    lv_fs_close(&f);
+    return size;
+}
+
+static lv_font_t *font_store_load(const char *path)
+{
+#if defined(CONFIG_TUX_FONT_STORE)
+    for (int i = 0; i < FONT_STORE_SLOTS; i++) {
+        font_entry_t *e = &font_entries[i];
+        if (e->font && strcmp(e->path, path) == 0) {
+            e->last_use = ++font_store_clock;
+            e->refs++;
+            font_store_stats.hits++;
+            return e->font;
+        }
+    }
+
+    uint32_t size = font_store_file_size(path);
+    if (size == 0 || strlen(path) >= FONT_PATH_LEN) return NULL;
+    font_entry_t *e = font_store_make_room(size);
+    if (e == NULL) {
+        ESP_LOGW(TAG, "Font store full, %s not loaded (%" PRIu32 " bytes)", path, size);
+        return NULL;
+    }
+
+    int64_t start = esp_timer_get_time();
+    lv_font_t *font = lv_font_load(path);
+    if (font == NULL) {
+        ESP_LOGE(TAG, "Font %s failed to load", path);
+        return NULL;
+    }
+    uint32_t us = esp_timer_get_time() - start;
+
+    strcpy(e->path, path);
+    e->font = font;
+    e->size = size;
+    e->refs = 1;
+    e->last_use = ++font_store_clock;
+    font_store_stats.loads++;
+    font_store_stats.load_us += us;
+    if (us > font_store_stats.load_us_max) font_store_stats.load_us_max = us;
+    font_store_stats.bytes += size;
+    if (font_store_stats.bytes > font_store_stats.bytes_peak) font_store_stats.bytes_peak = font_store_stats.bytes;
+    ESP_LOGI(TAG, "Font %s loaded, %" PRIu32 " bytes in %" PRIu32 "us", path, size, us);
+    return font;
+#else
+    return NULL;
+#endif
+}
+
+/* Font from path ("F:/fonts/x.bin", tried on S: too), fallback when it can't be loaded */
+static const lv_font_t *font_store_acquire(const char *path, const lv_font_t *fallback)
+{
+    lv_font_t *font = font_store_load(path);
+    if (font == NULL && path[0] == 'F') {
+        // Same file on the SD card - new fonts without reflashing SPIFFS
+        char sd_path[FONT_PATH_LEN];
+        snprintf(sd_path, sizeof(sd_path), "S%s", path + 1);
+        font = font_store_load(sd_path);
+    }
+    if (font) return font;
+
+    font_store_stats.fallbacks++;
+    return fallback;
+}
+
+/* Drops a reference taken by font_store_acquire(), fallback fonts are ignored */
+static void font_store_release(const lv_font_t *font)
+{
+    font_entry_t *e = font_store_find_font(font);
+    if (e && e->refs > 0) e->refs--;
+}
+
+/* Weather icon font of the given size (32, 42, 48, 56, 64 - whatever is on the drive) */
+static const lv_font_t *font_store_weather(int size, const lv_font_t *fallback)
+{
+    char path[FONT_PATH_LEN];
+    snprintf(path, sizeof(path), TUX_FONT_WEATHER_FMT, size);
+    return font_store_acquire(path, fallback);
+}
+
+static void font_store_report()
+{
+    uint32_t loads = font_store_stats.loads;
+    ESP_LOGI(TAG, "fonts hits:%" PRIu32 " loads:%" PRIu32 " fallbacks:%" PRIu32 " evictions:%" PRIu32
+                  " load avg:%" PRIu32 "us max:%" PRIu32 "us, %" PRIu32 "KB loaded (peak %" PRIu32 "KB) of %dKB",
+                font_store_stats.hits, loads, font_store_stats.fallbacks, font_store_stats.evictions,
+                loads ? (uint32_t)(font_store_stats.load_us / loads) : 0, font_store_stats.load_us_max,
+                font_store_stats.bytes / 1024, font_store_stats.bytes_peak / 1024, CONFIG_TUX_FONT_STORE_KB);
+}
+
+#endif // TUX_HELPER_FONT_STORE_H_
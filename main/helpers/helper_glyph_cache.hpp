@@ -0,0 +1,288 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Glyph cache for the big LVGL fonts
+    The clock (font_7seg_56) and the weather icon (font_fa_weather_42) are
+    4bpp bitmap fonts, so every redraw unpacks each glyph from flash nibble
+    by nibble while blending. glyph_cache_wrap() makes a copy of such a font
+    whose glyphs come out as ready A8 bitmaps (8bpp, one opacity byte per
+    pixel) decoded once into PSRAM and kept least recently used first within
+    CONFIG_TUX_GLYPH_CACHE_KB.
+
+    glyph_cache_atlas() pre-renders a fixed character set ("0123456789:"
+    for the clock) into one block that is never evicted, a minute change
+    then only copies bitmaps that are already there.
+
+    Glyphs are only asked for while drawing, which runs with the LVGL lock
+    held, so no extra locking. A bitmap stays valid until the next miss,
+    LVGL blends it before asking for the next one.
+*/
+
+#ifndef TUX_HELPER_GLYPH_CACHE_H_
+#define TUX_HELPER_GLYPH_CACHE_H_
+
+#include <string.h>
+#include "esp_heap_caps.h"
+
+#define GLYPH_CACHE_FONTS 4
+#define GLYPH_ATLAS_FIRST '0'
+#define GLYPH_ATLAS_LAST ':'        // '0'..'9' and ':' are next to each other
+#define GLYPH_ATLAS_COUNT (GLYPH_ATLAS_LAST - GLYPH_ATLAS_FIRST + 1)
+
+typedef struct {
+    lv_font_t font;                 // handed to LVGL, user_data points back here
+    const lv_font_t *base;          // original 1/2/4bpp font
+    const uint8_t *atlas[GLYPH_ATLAS_COUNT];
+    uint8_t *atlas_buf;
+    uint32_t atlas_size;
+} glyph_font_t;
+
+typedef struct {
+    const lv_font_t *font;          // NULL - free
+    uint32_t letter;
+    uint8_t *a8;
+    uint32_t size;
+    uint32_t last_use;
+} glyph_entry_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t atlas_hits;
+    uint32_t evictions;
+    uint32_t failed;                // no memory - base bitmap unpacked on the fly instead
+    uint64_t decode_us;
+    uint32_t bytes;
+    uint32_t bytes_peak;
+    uint32_t atlas_bytes;
+} glyph_cache_stats_t;
+
+static glyph_font_t glyph_fonts[GLYPH_CACHE_FONTS];
+static glyph_entry_t glyph_entries[CONFIG_TUX_GLYPH_CACHE_SLOTS];
+static glyph_cache_stats_t glyph_stats;
+static uint32_t glyph_clock = 0;
+static uint8_t *glyph_scratch = NULL;   // one glyph for when the cache is full
+static uint32_t glyph_scratch_size = 0;
+
+static inline glyph_font_t *glyph_font_get(const lv_font_t *font)
+{
+    return (glyph_font_t *)font->user_data;
+}
+
+/* Unpacks a 1/2/4bpp glyph into one opacity byte per pixel - rows are not padded in lv_font_fmt_txt */
+static void glyph_unpack_a8(const uint8_t *src, uint8_t bpp, uint32_t pixels, uint8_t *dst)
+{
+    if (bpp == 8) {
+        memcpy(dst, src, pixels);
+        return;
+    }
+    const uint8_t max = (1 << bpp) - 1;
+    uint32_t bit = 0;
+    for (uint32_t i = 0; i < pixels; i++, bit += bpp) {
+        uint8_t v = (src[bit >> 3] >> (8 - bpp - (bit & 7))) & max;
+        dst[i] = (uint16_t)v * 255 / max;
+    }
+}
+
+/* A8 size of a glyph of the base font, 0 when there is nothing to draw */
+static uint32_t glyph_base_size(const lv_font_t *base, uint32_t letter, lv_font_glyph_dsc_t *dsc)
+{
+    if (!base->get_glyph_dsc(base, dsc, letter, 0)) return 0;
+    if (dsc->bpp == 3 || dsc->bpp > 8) return 0;       // not handled, LVGL gets the base bitmap
+    return (uint32_t)dsc->box_w * dsc->box_h;
+}
+
+static bool glyph_cache_get_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc, uint32_t letter, uint32_t letter_next)
+{
+    const lv_font_t *base = glyph_font_get(font)->base;
+    if (!base->get_glyph_dsc(base, dsc, letter, letter_next)) return false;
+    if (dsc->bpp == 1 || dsc->bpp == 2 || dsc->bpp == 4) dsc->bpp = 8;
+    return true;
+}
+
+// Frees the least recently used entries until size fits, returns a free slot
+static glyph_entry_t *glyph_cache_make_room(uint32_t size)
+{
+    if (size > CONFIG_TUX_GLYPH_CACHE_KB * 1024) return NULL;
+    while (true) {
+        glyph_entry_t *free_slot = NULL, *lru = NULL;
+        for (int i = 0; i < CONFIG_TUX_GLYPH_CACHE_SLOTS; i++) {
+            glyph_entry_t *e = &glyph_entries[i];
+            if (e->font == NULL) { if (!free_slot) free_slot = e; continue; }
+            if (!lru || e->last_use < lru->last_use) lru = e;
+        }
+        if (free_slot && glyph_stats.bytes + size <= CONFIG_TUX_GLYPH_CACHE_KB * 1024) return free_slot;
+        if (lru == NULL) return NULL;
+
+        glyph_stats.bytes -= lru->size;
+        glyph_stats.evictions++;
+        heap_caps_free(lru->a8);
+        memset(lru, 0, sizeof(*lru));
+    }
+}
+
+static const uint8_t *glyph_cache_get_bitmap(const lv_font_t *font, uint32_t letter)
+{
+    glyph_font_t *gf = glyph_font_get(font);
+    if (letter >= GLYPH_ATLAS_FIRST && letter <= GLYPH_ATLAS_LAST && gf->atlas[letter - GLYPH_ATLAS_FIRST]) {
+        glyph_stats.atlas_hits++;
+        return gf->atlas[letter - GLYPH_ATLAS_FIRST];
+    }
+
+    for (int i = 0; i < CONFIG_TUX_GLYPH_CACHE_SLOTS; i++) {
+        glyph_entry_t *e = &glyph_entries[i];
+        if (e->font == font && e->letter == letter) {
+            e->last_use = ++glyph_clock;
+            glyph_stats.hits++;
+            return e->a8;
+        }
+    }
+
+    lv_font_glyph_dsc_t dsc;
+    const lv_font_t *base = gf->base;
+    uint32_t size = glyph_base_size(base, letter, &dsc);
+    const uint8_t *src = base->get_glyph_bitmap(base, letter);
+    if (size == 0 || src == NULL) return src;
+
+    glyph_stats.misses++;
+    int64_t start = esp_timer_get_time();
+    uint8_t *a8 = NULL;
+    glyph_entry_t *e = glyph_cache_make_room(size);
+    if (e) a8 = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (a8 == NULL) {
+        // Out of budget or memory - the descriptor already said 8bpp, so unpack into scratch
+        glyph_stats.failed++;
+        if (glyph_scratch_size < size) {
+            heap_caps_free(glyph_scratch);
+            glyph_scratch = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+            glyph_scratch_size = glyph_scratch ? size : 0;
+        }
+        if (glyph_scratch == NULL) return NULL;
+        a8 = glyph_scratch;
+        e = NULL;
+    }
+    glyph_unpack_a8(src, dsc.bpp, size, a8);
+    glyph_stats.decode_us += esp_timer_get_time() - start;
+    if (e == NULL) return a8;
+
+    e->font = font;
+    e->letter = letter;
+    e->a8 = a8;
+    e->size = size;
+    e->last_use = ++glyph_clock;
+    glyph_stats.bytes += size;
+    if (glyph_stats.bytes > glyph_stats.bytes_peak) glyph_stats.bytes_peak = glyph_stats.bytes;
+    return a8;
+}
+
+/* Returns a cached copy of base to use instead of it, base itself without PSRAM or free slots */
+static const lv_font_t *glyph_cache_wrap(const lv_font_t *base)
+{
+#if defined(CONFIG_TUX_GLYPH_CACHE)
+    if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) == 0) return base;
+    for (int i = 0; i < GLYPH_CACHE_FONTS; i++) {
+        glyph_font_t *gf = &glyph_fonts[i];
+        if (gf->base == base) return &gf->font;
+        if (gf->base) continue;
+
+        gf->base = base;
+        gf->font = *base;
+        gf->font.get_glyph_dsc = glyph_cache_get_dsc;
+        gf->font.get_glyph_bitmap = glyph_cache_get_bitmap;
+        gf->font.user_data = gf;
+        return &gf->font;
+    }
+#endif
+    return base;
+}
+
+/* Drops the wrapper of base and its glyphs - before base itself is freed */
+static void glyph_cache_forget(const lv_font_t *base)
+{
+    for (int i = 0; i < GLYPH_CACHE_FONTS; i++) {
+        glyph_font_t *gf = &glyph_fonts[i];
+        if (gf->base != base) continue;
+        for (int j = 0; j < CONFIG_TUX_GLYPH_CACHE_SLOTS; j++) {
+            glyph_entry_t *e = &glyph_entries[j];
+            if (e->font != &gf->font) continue;
+            glyph_stats.bytes -= e->size;
+            heap_caps_free(e->a8);
+            memset(e, 0, sizeof(*e));
+        }
+        if (gf->atlas_buf) {
+            glyph_stats.atlas_bytes -= gf->atlas_size;
+            heap_caps_free(gf->atlas_buf);
+        }
+        memset(gf, 0, sizeof(*gf));
+    }
+}
+
+/* Pre-renders the characters of '0'..'9' and ':' found in chars into one block that is never evicted */
+static bool glyph_cache_atlas(const lv_font_t *font, const char *chars)
+{
+    if (font->get_glyph_bitmap != glyph_cache_get_bitmap) return false;    // not wrapped
+    glyph_font_t *gf = glyph_font_get(font);
+    if (gf->atlas_buf) return true;
+
+    lv_font_glyph_dsc_t dsc;
+    uint32_t total = 0;
+    for (const char *c = chars; *c; c++) {
+        if (*c < GLYPH_ATLAS_FIRST || *c > GLYPH_ATLAS_LAST) continue;
+        total += glyph_base_size(gf->base, *c, &dsc);
+    }
+    if (total == 0) return false;
+
+    gf->atlas_buf = (uint8_t *)heap_caps_malloc(total, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (gf->atlas_buf == NULL) return false;
+
+    uint8_t *p = gf->atlas_buf;
+    for (const char *c = chars; *c; c++) {
+        if (*c < GLYPH_ATLAS_FIRST || *c > GLYPH_ATLAS_LAST) continue;
+        uint32_t size = glyph_base_size(gf->base, *c, &dsc);
+        const uint8_t *src = gf->base->get_glyph_bitmap(gf->base, *c);
+        if (size == 0 || src == NULL) continue;
+        glyph_unpack_a8(src, dsc.bpp, size, p);
+        gf->atlas[*c - GLYPH_ATLAS_FIRST] = p;
+        p += size;
+    }
+    gf->atlas_size = total;
+    glyph_stats.atlas_bytes += total;
+    ESP_LOGI(TAG, "Glyph atlas \"%s\" %" PRIu32 " bytes", chars, total);
+    return true;
+}
+
+static void glyph_cache_report()
+{
+    uint32_t misses = glyph_stats.misses;
+    ESP_LOGI(TAG, "glyphs hits:%" PRIu32 " misses:%" PRIu32 " atlas:%" PRIu32 " evictions:%" PRIu32
+                  " failed:%" PRIu32 " decode avg:%" PRIu32 "us, %" PRIu32 "KB cached (peak %" PRIu32 "KB) of %dKB"
+                  " + %" PRIu32 "B atlas",
+                glyph_stats.hits, misses, glyph_stats.atlas_hits, glyph_stats.evictions, glyph_stats.failed,
+                misses ? (uint32_t)(glyph_stats.decode_us / misses) : 0,
+                glyph_stats.bytes / 1024, glyph_stats.bytes_peak / 1024, CONFIG_TUX_GLYPH_CACHE_KB,
+                glyph_stats.atlas_bytes);
+}
+
+#endif // TUX_HELPER_GLYPH_CACHE_H_
@@ -0,0 +1,374 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Block cache and read-ahead for the LVGL drives F: (SPIFFS, lv_fs_posix)
+    and S: (SD card, lv_fs_stdio)
+    Both drivers run without a cache, so image decoders and font loaders
+    that read a few bytes at a time end up with one VFS call each. The
+    drivers registered by lv_init() are wrapped here: reads are served from
+    fixed size blocks kept per drive, and once a file is read sequentially
+    the following blocks are fetched ahead in the same pass. Large reads
+    skip the cache and go straight to the driver.
+
+    All lv_fs calls run with the LVGL lock held, so no extra locking.
+*/
+
+#ifndef TUX_HELPER_LV_FS_CACHE_H_
+#define TUX_HELPER_LV_FS_CACHE_H_
+
+#include <string.h>
+#include <misc/lv_fs.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+#define FS_CACHE_DRIVES 2
+
+typedef struct {
+    uint32_t key;           // file, 0 - free
+    uint32_t index;         // block number in the file
+    uint32_t len;           // valid bytes, short at the end of the file
+    uint32_t last_use;
+} fs_block_t;
+
+typedef struct {
+    uint32_t reads;
+    uint32_t hits;          // blocks
+    uint32_t misses;
+    uint32_t read_ahead;    // blocks fetched before they were asked for
+    uint32_t bypass;        // large reads straight to the driver
+    uint64_t bytes;         // delivered to LVGL
+    uint64_t bytes_disk;    // read from the driver
+    uint64_t read_us;       // time spent in read_cb
+} fs_cache_stats_t;
+
+typedef struct {
+    lv_fs_drv_t *drv;
+    lv_fs_drv_t inner;      // original callbacks
+    uint8_t *mem;
+    fs_block_t *blocks;
+    uint16_t count;
+    uint32_t clock;
+    fs_cache_stats_t stats;
+} fs_cache_t;
+
+typedef struct {
+    void *inner;            // file handle of the wrapped driver
+    uint32_t key;
+    uint32_t pos;
+    uint32_t size;
+    uint32_t inner_pos;     // where the wrapped driver's position is
+    uint32_t last_block;    // block of the previous read
+    uint8_t seq;            // reads that moved on to the next block, in a row
+} fs_cache_file_t;
+
+static fs_cache_t fs_caches[FS_CACHE_DRIVES];
+
+static fs_cache_t *fs_cache_get(lv_fs_drv_t *drv)
+{
+    for (int i = 0; i < FS_CACHE_DRIVES; i++) {
+        if (fs_caches[i].drv == drv) return &fs_caches[i];
+    }
+    return NULL;
+}
+
+static uint8_t *fs_cache_data(fs_cache_t *c, fs_block_t *b)
+{
+    return c->mem + (b - c->blocks) * CONFIG_TUX_FS_BLOCK_SIZE;
+}
+
+static fs_block_t *fs_cache_find(fs_cache_t *c, uint32_t key, uint32_t index)
+{
+    for (int i = 0; i < c->count; i++) {
+        fs_block_t *b = &c->blocks[i];
+        if (b->key == key && b->index == index) return b;
+    }
+    return NULL;
+}
+
+static fs_block_t *fs_cache_victim(fs_cache_t *c)
+{
+    fs_block_t *lru = &c->blocks[0];
+    for (int i = 0; i < c->count; i++) {
+        fs_block_t *b = &c->blocks[i];
+        if (b->key == 0) return b;
+        if (b->last_use < lru->last_use) lru = b;
+    }
+    return lru;
+}
+
+static void fs_cache_invalidate(fs_cache_t *c, uint32_t key)
+{
+    for (int i = 0; i < c->count; i++) {
+        if (c->blocks[i].key == key) c->blocks[i].key = 0;
+    }
+}
+
+// Raw read through the wrapped driver at pos
+static lv_fs_res_t fs_cache_inner_read(fs_cache_t *c, fs_cache_file_t *f, uint32_t pos,
+                                       void *buf, uint32_t btr, uint32_t *br)
+{
+    lv_fs_res_t res = LV_FS_RES_OK;
+    if (f->inner_pos != pos) res = c->inner.seek_cb(c->drv, f->inner, pos, LV_FS_SEEK_SET);
+    if (res == LV_FS_RES_OK) res = c->inner.read_cb(c->drv, f->inner, buf, btr, br);
+    f->inner_pos = (res == LV_FS_RES_OK) ? pos + *br : UINT32_MAX;
+    if (res == LV_FS_RES_OK) c->stats.bytes_disk += *br;
+    return res;
+}
+
+// Block of the file, read from the driver on a miss - with read-ahead when sequential
+static fs_block_t *fs_cache_block(fs_cache_t *c, fs_cache_file_t *f, uint32_t index)
+{
+    if (index != f->last_block) {
+        f->seq = (index == f->last_block + 1) ? (f->seq < 255 ? f->seq + 1 : 255) : 0;
+        f->last_block = index;
+    }
+
+    fs_block_t *b = fs_cache_find(c, f->key, index);
+    if (b) {
+        c->stats.hits++;
+        b->last_use = ++c->clock;
+        return b;
+    }
+    c->stats.misses++;
+
+    // Second block in a row - the rest of the file is probably wanted too
+    uint32_t ahead = (f->seq >= 1) ? CONFIG_TUX_FS_READ_AHEAD : 0;
+    if (ahead >= c->count) ahead = c->count - 1;
+
+    fs_block_t *first = NULL;
+    for (uint32_t i = 0; i <= ahead; i++) {
+        uint32_t pos = (index + i) * CONFIG_TUX_FS_BLOCK_SIZE;
+        if (pos >= f->size) break;
+        if (i > 0 && fs_cache_find(c, f->key, index + i)) break;
+
+        fs_block_t *victim = fs_cache_victim(c);
+        uint32_t len = 0;
+        victim->key = 0;
+        if (fs_cache_inner_read(c, f, pos, fs_cache_data(c, victim), CONFIG_TUX_FS_BLOCK_SIZE, &len) != LV_FS_RES_OK || len == 0) break;
+
+        victim->key = f->key;
+        victim->index = index + i;
+        victim->len = len;
+        victim->last_use = ++c->clock;
+        if (i == 0) first = victim;
+        else c->stats.read_ahead++;
+    }
+    return first;
+}
+
+static void *fs_cache_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode)
+{
+    fs_cache_t *c = fs_cache_get(drv);
+    void *inner = c->inner.open_cb(drv, path, mode);
+    if (inner == NULL) return NULL;
+
+    fs_cache_file_t *f = (fs_cache_file_t *)lv_mem_alloc(sizeof(fs_cache_file_t));
+    if (f == NULL) {
+        c->inner.close_cb(drv, inner);
+        return NULL;
+    }
+    memset(f, 0, sizeof(*f));
+    f->inner = inner;
+    f->last_block = UINT32_MAX - 1;     // block 0 doesn't count as the next one
+
+    // Path and size name the cached blocks, a rewritten file gets new ones
+    c->inner.seek_cb(drv, inner, 0, LV_FS_SEEK_END);
+    c->inner.tell_cb(drv, inner, &f->size);
+    c->inner.seek_cb(drv, inner, 0, LV_FS_SEEK_SET);
+
+    uint32_t key = 2166136261u;     // FNV-1a
+    for (const char *p = path; *p; p++) key = (key ^ (uint8_t)*p) * 16777619u;
+    key = (key ^ f->size) * 16777619u;
+    f->key = key ? key : 1;
+    return f;
+}
+
+static lv_fs_res_t fs_cache_close(lv_fs_drv_t *drv, void *file_p)
+{
+    fs_cache_t *c = fs_cache_get(drv);
+    fs_cache_file_t *f = (fs_cache_file_t *)file_p;
+    lv_fs_res_t res = c->inner.close_cb(drv, f->inner);
+    lv_mem_free(f);
+    return res;
+}
+
+static lv_fs_res_t fs_cache_read(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br)
+{
+    fs_cache_t *c = fs_cache_get(drv);
+    fs_cache_file_t *f = (fs_cache_file_t *)file_p;
+    int64_t start = esp_timer_get_time();
+    lv_fs_res_t res = LV_FS_RES_OK;
+
+    *br = 0;
+    c->stats.reads++;
+    if (f->pos >= f->size) return LV_FS_RES_OK;
+    if (btr > f->size - f->pos) btr = f->size - f->pos;
+
+    if (btr >= CONFIG_TUX_FS_BLOCK_SIZE * 2) {
+        // Whole image rows and the like - copying through the cache gains nothing
+        c->stats.bypass++;
+        res = fs_cache_inner_read(c, f, f->pos, buf, btr, br);
+        f->pos += *br;
+        f->last_block = f->pos / CONFIG_TUX_FS_BLOCK_SIZE - 1;     // still a sequential scan
+    } else {
+        while (*br < btr) {
+            uint32_t offset = f->pos % CONFIG_TUX_FS_BLOCK_SIZE;
+            fs_block_t *b = fs_cache_block(c, f, f->pos / CONFIG_TUX_FS_BLOCK_SIZE);
+            if (b == NULL || offset >= b->len) {
+                if (*br == 0) res = LV_FS_RES_HW_ERR;
+                break;
+            }
+            uint32_t n = LV_MIN(b->len - offset, btr - *br);
+            memcpy((uint8_t *)buf + *br, fs_cache_data(c, b) + offset, n);
+            *br += n;
+            f->pos += n;
+        }
+    }
+
+    c->stats.bytes += *br;
+    c->stats.read_us += esp_timer_get_time() - start;
+    return res;
+}
+
+static lv_fs_res_t fs_cache_write(lv_fs_drv_t *drv, void *file_p, const void *buf, uint32_t btw, uint32_t *bw)
+{
+    fs_cache_t *c = fs_cache_get(drv);
+    fs_cache_file_t *f = (fs_cache_file_t *)file_p;
+    if (c->inner.write_cb == NULL) return LV_FS_RES_NOT_IMP;
+
+    lv_fs_res_t res = c->inner.seek_cb(drv, f->inner, f->pos, LV_FS_SEEK_SET);
+    if (res == LV_FS_RES_OK) res = c->inner.write_cb(drv, f->inner, buf, btw, bw);
+    f->inner_pos = UINT32_MAX;
+    if (res != LV_FS_RES_OK) return res;
+
+    fs_cache_invalidate(c, f->key);
+    f->pos += *bw;
+    if (f->pos > f->size) f->size = f->pos;
+    return res;
+}
+
+static lv_fs_res_t fs_cache_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    fs_cache_file_t *f = (fs_cache_file_t *)file_p;
+    switch (whence) {
+        case LV_FS_SEEK_SET: f->pos = pos; break;
+        case LV_FS_SEEK_CUR: f->pos += pos; break;
+        case LV_FS_SEEK_END: f->pos = f->size + pos; break;
+        default: return LV_FS_RES_INV_PARAM;
+    }
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_cache_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p)
+{
+    *pos_p = ((fs_cache_file_t *)file_p)->pos;
+    return LV_FS_RES_OK;
+}
+
+/* After lv_init() - wraps the driver registered for letter, budget 0 leaves it alone */
+static bool lv_fs_cache_attach(char letter, uint32_t budget_kb)
+{
+    lv_fs_drv_t *drv = lv_fs_get_drv(letter);
+    uint16_t count = budget_kb * 1024 / CONFIG_TUX_FS_BLOCK_SIZE;
+    if (drv == NULL || count < 2 || fs_cache_get(drv)) return false;
+
+    fs_cache_t *c = fs_cache_get(NULL);     // free slot
+    if (c == NULL) return false;
+
+    uint8_t *mem = (uint8_t *)heap_caps_malloc(count * CONFIG_TUX_FS_BLOCK_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (mem == NULL) mem = (uint8_t *)malloc(count * CONFIG_TUX_FS_BLOCK_SIZE);
+    fs_block_t *blocks = (fs_block_t *)calloc(count, sizeof(fs_block_t));
+    if (mem == NULL || blocks == NULL) {
+        ESP_LOGE(TAG, "%c: block cache allocation failed", letter);
+        heap_caps_free(mem);
+        free(blocks);
+        return false;
+    }
+
+    c->inner = *drv;
+    c->mem = mem;
+    c->blocks = blocks;
+    c->count = count;
+    c->drv = drv;
+
+    drv->open_cb = fs_cache_open;
+    drv->close_cb = fs_cache_close;
+    drv->read_cb = fs_cache_read;
+    drv->write_cb = fs_cache_write;
+    drv->seek_cb = fs_cache_seek;
+    drv->tell_cb = fs_cache_tell;
+
+    ESP_LOGI(TAG, "%c: %d x %dB block cache, read-ahead %d blocks", letter,
+                count, CONFIG_TUX_FS_BLOCK_SIZE, CONFIG_TUX_FS_READ_AHEAD);
+    return true;
+}
+
+static void lv_fs_cache_init()
+{
+#if defined(CONFIG_TUX_FS_CACHE)
+    lv_fs_cache_attach(LV_FS_POSIX_LETTER, CONFIG_TUX_FS_CACHE_KB_F);
+    lv_fs_cache_attach(LV_FS_STDIO_LETTER, CONFIG_TUX_FS_CACHE_KB_S);
+#endif
+}
+
+static void lv_fs_cache_report()
+{
+    for (int i = 0; i < FS_CACHE_DRIVES; i++) {
+        fs_cache_t *c = &fs_caches[i];
+        if (c->drv == NULL) continue;
+        const fs_cache_stats_t &st = c->stats;
+        ESP_LOGI(TAG, "%c: reads:%" PRIu32 " blocks hit:%" PRIu32 " miss:%" PRIu32 " ahead:%" PRIu32
+                      " bypass:%" PRIu32 " %" PRIu32 "KB delivered, %" PRIu32 "KB from disk, %.2fMB/s",
+                    c->drv->letter, st.reads, st.hits, st.misses, st.read_ahead, st.bypass,
+                    (uint32_t)(st.bytes / 1024), (uint32_t)(st.bytes_disk / 1024),
+                    st.read_us ? (double)st.bytes / st.read_us : 0.0);
+    }
+}
+
+/*
+    Throughput of reading path through lv_fs in chunk sized reads, run it
+    twice to see cold (first pass) and warm cache numbers. LVGL lock held.
+*/
+static void lv_fs_cache_benchmark(const char *path, uint32_t chunk)
+{
+    lv_fs_file_t f;
+    if (lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        ESP_LOGW(TAG, "%s not found, skipped", path);
+        return;
+    }
+
+    uint8_t *buf = (uint8_t *)lv_mem_alloc(chunk);
+    uint32_t total = 0, br = 0;
+    int64_t start = esp_timer_get_time();
+    while (buf && lv_fs_read(&f, buf, chunk, &br) == LV_FS_RES_OK && br > 0) total += br;
+    int64_t elapsed = esp_timer_get_time() - start;
+    lv_fs_close(&f);
+    lv_mem_free(buf);
+
+    ESP_LOGW(TAG, "[fs] %s %" PRIu32 " bytes in %" PRIu32 "B reads : %lldus, %.2fMB/s",
+                path, total, chunk, elapsed, elapsed ? (double)total / elapsed : 0.0);
+}
+
+#endif // TUX_HELPER_LV_FS_CACHE_H_
@@ -0,0 +1,101 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/*
+    Bounded multi-producer / single-consumer ring with per slot sequence
+    numbers (D. Vyukov bounded queue). No lock and no heap - producers claim
+    a slot with one CAS on head, the single consumer frees it by bumping the
+    slot sequence. Plain C++, also built on the host (test/host).
+*/
+
+#ifndef TUX_HELPER_MPSC_QUEUE_H_
+#define TUX_HELPER_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+template <typename T, size_t N>
+class MpscQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Queue depth must be a power of 2");
+
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        T data;
+    };
+
+    Slot slots[N];
+    std::atomic<uint32_t> head;     // next position for producers
+    uint32_t tail;                  // next position for the consumer (single)
+
+public:
+    MpscQueue() : head(0), tail(0)
+    {
+        for (uint32_t i = 0; i < N; i++) slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Any task - returns false if the queue is full
+    bool push(const T &item)
+    {
+        Slot *slot;
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            slot = &slots[pos & (N - 1)];
+            uint32_t seq = slot->seq.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            if (diff == 0) {
+                // Slot is free, claim it
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;   // consumer hasn't freed this slot yet => full
+            } else {
+                pos = head.load(std::memory_order_relaxed);     // another producer won
+            }
+        }
+        slot->data = item;
+        slot->seq.store(pos + 1, std::memory_order_release);    // publish
+        return true;
+    }
+
+    // Consumer only - returns false if empty (or the next producer isn't done copying yet)
+    bool pop(T &item)
+    {
+        Slot *slot = &slots[tail & (N - 1)];
+        uint32_t seq = slot->seq.load(std::memory_order_acquire);
+        if ((int32_t)(seq - (tail + 1)) < 0) return false;
+        item = slot->data;
+        slot->seq.store(tail + N, std::memory_order_release);   // hand the slot back to producers
+        tail++;
+        return true;
+    }
+
+    uint32_t size() const
+    {
+        return head.load(std::memory_order_relaxed) - tail;
+    }
+};
+
+#endif // TUX_HELPER_MPSC_QUEUE_H_
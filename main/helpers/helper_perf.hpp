@@ -0,0 +1,353 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/*
+    Frame timing and flush statistics for LVGL.
+    render_start_cb / monitor_cb of the display driver mark the start and
+    end of every refresh cycle, flush_push_area() adds the areas it pushes.
+    With the async flush the areas are pushed from the flush task on the
+    other core, so everything shared is updated under perf_lock.
+    Numbers are printed over serial - enable the scripted page benchmark
+    with CONFIG_TUX_UI_BENCHMARK (idf.py menuconfig => Performance Config)
+*/
+
+#ifndef TUX_HELPER_PERF_H_
+#define TUX_HELPER_PERF_H_
+
+#include "esp_timer.h"
+#if LV_MEM_CUSTOM
+#include "tux_mem.h"
+#endif
+
+typedef struct {
+    uint32_t frames;                // Refresh cycles completed
+    uint32_t frame_us;              // Last refresh cycle (render + flush)
+    uint32_t frame_us_max;
+    uint64_t frame_us_total;
+
+    uint32_t frame_areas;           // Areas flushed in the last refresh cycle
+    uint32_t frame_px;              // Pixels flushed in the last refresh cycle
+    uint32_t frame_bytes;           // Bytes pushed to the panel in the last refresh cycle
+    uint32_t frame_transfers;       // Bus transfers (address windows) in the last refresh cycle
+
+    uint64_t areas_total;
+    uint64_t px_total;
+    uint64_t bytes_total;
+    uint64_t transfers_total;
+    uint64_t merged_total;          // Areas merged into the previous transfer
+    uint64_t flush_us_total;        // Time spent pushing pixels to the panel
+    uint64_t wait_us_total;         // Time LVGL waited for a flush to complete
+    uint64_t overlap_us_total;      // Transfer time during which LVGL was rendering
+} tux_perf_t;
+
+static tux_perf_t perf_stats;
+static portMUX_TYPE perf_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Time LVGL could not render - between refresh cycles or waiting for a draw buffer.
+// Sampled at the start and the end of a transfer, the difference is the part of
+// the transfer that did not overlap with rendering.
+static int64_t perf_blocked_us;
+static int64_t perf_blocked_since;      // 0 while LVGL renders
+
+// Accumulators for the refresh cycle in progress
+static int64_t perf_frame_start;
+static uint32_t perf_cur_areas;
+static uint32_t perf_cur_px;
+static uint32_t perf_cur_bytes;
+static uint32_t perf_cur_transfers;
+
+// perf_lock held
+static inline void perf_set_blocked(bool blocked, int64_t now)
+{
+    if (blocked && !perf_blocked_since) {
+        perf_blocked_since = now;
+    } else if (!blocked && perf_blocked_since) {
+        perf_blocked_us += now - perf_blocked_since;
+        perf_blocked_since = 0;
+    }
+}
+
+// perf_lock held
+static inline int64_t perf_blocked_at(int64_t now)
+{
+    return perf_blocked_us + (perf_blocked_since ? now - perf_blocked_since : 0);
+}
+
+static void perf_reset()
+{
+    portENTER_CRITICAL(&perf_lock);
+    memset(&perf_stats, 0, sizeof(perf_stats));
+    perf_cur_areas = perf_cur_px = perf_cur_bytes = perf_cur_transfers = 0;
+    perf_blocked_us = 0;
+    perf_blocked_since = esp_timer_get_time();
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+// LVGL starts rendering a new refresh cycle
+static void perf_render_start_cb(lv_disp_drv_t *disp_drv)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&perf_lock);
+    perf_frame_start = now;
+    perf_cur_areas = perf_cur_px = perf_cur_bytes = perf_cur_transfers = 0;
+    perf_set_blocked(false, now);
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+// Area was merged into the running bus transfer or needed a new address window
+static inline void perf_flush_merged(bool merged)
+{
+    portENTER_CRITICAL(&perf_lock);
+    if (merged) perf_stats.merged_total++;
+    else perf_cur_transfers++;
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+// Start of a transfer - returns the blocked time stamp for perf_flush_area()
+static inline int64_t perf_flush_begin(int64_t now)
+{
+    portENTER_CRITICAL(&perf_lock);
+    int64_t blocked = perf_blocked_at(now);
+    portEXIT_CRITICAL(&perf_lock);
+    return blocked;
+}
+
+// Called for every area pushed to the panel, when its transfer is complete
+static inline void perf_flush_area(uint32_t px, uint32_t bytes, int64_t flush_start, int64_t blocked_start)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t flush_us = now - flush_start;
+
+    portENTER_CRITICAL(&perf_lock);
+    perf_cur_areas++;
+    perf_cur_px += px;
+    perf_cur_bytes += bytes;
+    perf_stats.flush_us_total += flush_us;
+#if defined(CONFIG_TUX_FLUSH_ASYNC)
+    // Sync flush never overlaps, LVGL waits inside display_flush()
+    int64_t overlap_us = flush_us - (perf_blocked_at(now) - blocked_start);
+    if (overlap_us > 0) perf_stats.overlap_us_total += overlap_us;
+#endif
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+// LVGL waits for a draw buffer which is still on the bus (async flush)
+static inline void perf_flush_wait_begin(int64_t now)
+{
+    portENTER_CRITICAL(&perf_lock);
+    perf_set_blocked(true, now);
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+static inline void perf_flush_wait_end(int64_t wait_start)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&perf_lock);
+    perf_set_blocked(false, now);
+    perf_stats.wait_us_total += now - wait_start;
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+// LVGL finished a refresh cycle (all areas rendered, the last one may still be on the bus)
+static void perf_monitor_cb(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t frame_us = (uint32_t)(now - perf_frame_start);
+
+    portENTER_CRITICAL(&perf_lock);
+    perf_set_blocked(true, now);
+    perf_stats.frames++;
+    perf_stats.frame_us = frame_us;
+    perf_stats.frame_us_total += frame_us;
+    if (frame_us > perf_stats.frame_us_max) perf_stats.frame_us_max = frame_us;
+
+    perf_stats.frame_areas = perf_cur_areas;
+    perf_stats.frame_px = perf_cur_px;
+    perf_stats.frame_bytes = perf_cur_bytes;
+    perf_stats.frame_transfers = perf_cur_transfers;
+    perf_stats.areas_total += perf_cur_areas;
+    perf_stats.px_total += perf_cur_px;
+    perf_stats.bytes_total += perf_cur_bytes;
+    perf_stats.transfers_total += perf_cur_transfers;
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+static void perf_log_frame(const char *label, int frame)
+{
+    ESP_LOGI(TAG, "[%s] frame %3d : %6" PRIu32 "us  areas:%2" PRIu32 "  transfers:%2" PRIu32 "  px:%6" PRIu32 "  bytes:%6" PRIu32,
+                label, frame, perf_stats.frame_us, perf_stats.frame_areas, perf_stats.frame_transfers,
+                perf_stats.frame_px, perf_stats.frame_bytes);
+}
+
+static void lv_mem_report(const char *label);
+
+static void perf_report(const char *label)
+{
+    portENTER_CRITICAL(&perf_lock);
+    tux_perf_t st = perf_stats;
+    portEXIT_CRITICAL(&perf_lock);
+
+    if (st.frames == 0) {
+        ESP_LOGW(TAG, "[%s] no frames rendered", label);
+        return;
+    }
+    uint32_t avg_us = st.frame_us_total / st.frames;
+    ESP_LOGW(TAG, "[%s] frames:%" PRIu32 " avg:%" PRIu32 "us max:%" PRIu32 "us (%.1f fps) "
+                  "px/frame:%" PRIu32 " bytes:%" PRIu64 " flush:%" PRIu64 "us",
+                label, st.frames, avg_us, st.frame_us_max,
+                avg_us ? 1000000.0f / avg_us : 0.0f,
+                (uint32_t)(st.px_total / st.frames),
+                st.bytes_total, st.flush_us_total);
+
+    // Merge ratio => how many flushed areas rode on an already open transfer
+    ESP_LOGW(TAG, "[%s] areas/frame:%.1f transfers/frame:%.1f merge ratio:%.0f%%",
+                label, (float)st.areas_total / st.frames,
+                (float)st.transfers_total / st.frames,
+                st.areas_total ? 100.0f * st.merged_total / st.areas_total : 0.0f);
+
+    // Overlap => part of the bus transfer time during which LVGL was rendering,
+    // from the time stamps of every transfer. Always 0% with synchronous flush
+    // since LVGL blocks inside display_flush()
+#if defined(CONFIG_TUX_FLUSH_ASYNC)
+    ESP_LOGW(TAG, "[%s] async flush - transfer:%" PRIu64 "us waited:%" PRIu64 "us overlap:%" PRIu64 "us (%.0f%%)",
+                label, st.flush_us_total, st.wait_us_total, st.overlap_us_total,
+                st.flush_us_total ? 100.0f * st.overlap_us_total / st.flush_us_total : 0.0f);
+#else
+    ESP_LOGW(TAG, "[%s] sync flush - transfer:%" PRIu64 "us overlap:0%%", label, st.flush_us_total);
+#endif
+    lv_mem_report(label);
+}
+
+/*
+    LVGL memory usage - same numbers for the built-in pool (LV_MEM_SIZE)
+    and the heap based allocator (tux_mem.c, CONFIG_TUX_LV_MEM_CUSTOM)
+    Call with the LVGL lock held.
+*/
+typedef struct {
+    uint32_t used;
+    uint32_t peak;
+    uint32_t free;              // pool: free bytes left / heap: free bytes in the PSRAM (or internal) heap
+    uint8_t frag_pct;
+} tux_lv_mem_t;
+
+static void lv_mem_usage(tux_lv_mem_t *mem)
+{
+#if LV_MEM_CUSTOM
+    tux_mem_stats_t st;
+    tux_mem_get_stats(&st);
+    mem->used = st.used;
+    mem->peak = st.peak;
+    mem->free = st.free_psram ? st.free_psram : st.free_internal;
+    mem->frag_pct = st.free_psram ? st.frag_psram : st.frag_internal;
+#else
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    mem->used = mon.total_size - mon.free_size;
+    mem->peak = mon.max_used;
+    mem->free = mon.free_size;
+    mem->frag_pct = mon.frag_pct;
+#endif
+}
+
+static void lv_mem_report(const char *label)
+{
+    tux_lv_mem_t mem;
+    lv_mem_usage(&mem);
+    ESP_LOGW(TAG, "[%s] lv_mem used:%" PRIu32 " peak:%" PRIu32 " free:%" PRIu32 " frag:%d%%",
+                label, mem.used, mem.peak, mem.free, mem.frag_pct);
+#if LV_MEM_CUSTOM
+    tux_mem_stats_t st;
+    tux_mem_get_stats(&st);
+    ESP_LOGW(TAG, "[%s] lv_mem internal:%u psram:%u live:%" PRIu32 " allocs:%" PRIu32 " failed:%" PRIu32 " fallbacks:%" PRIu32,
+                label, (unsigned)st.used_internal, (unsigned)st.used_psram, st.live, st.allocs, st.failed, st.fallbacks);
+    char classes[160];
+    int len = 0;
+    for (int i = 0; i < TUX_MEM_CLASSES && len < sizeof(classes); i++) {
+        len += snprintf(classes + len, sizeof(classes) - len, " %s:%" PRIu32, tux_mem_class_name(i), st.by_class[i]);
+    }
+    ESP_LOGW(TAG, "[%s] lv_mem size classes%s", label, classes);
+#endif
+}
+
+/*
+    GUI task statistics - how long the task slept (CPU idle for LVGL),
+    what woke it up and how long the LVGL lock was held per run.
+*/
+typedef struct {
+    uint64_t idle_us;
+    uint32_t wakeups_timer;         // next LVGL timer was due
+    uint32_t wakeups_event;         // touch interrupt or posted UI message
+    uint64_t lock_us;               // lock held by gui_task
+    uint32_t lock_count;
+    uint32_t lock_us_max;           // worst frame stall - touch and rendering wait this long
+    uint32_t stalls;                // gui_task runs longer than CONFIG_TUX_GUI_STALL_MS
+    uint64_t lock_other_us;         // lock held by other tasks (lvgl_acquire)
+    uint32_t lock_other_count;
+    uint32_t lock_other_us_max;
+    int64_t since;
+} tux_gui_stats_t;
+
+static tux_gui_stats_t gui_stats;
+
+static inline void gui_stats_idle(int64_t idle_us, bool woken)
+{
+    gui_stats.idle_us += idle_us;
+    if (woken) gui_stats.wakeups_event++;
+    else gui_stats.wakeups_timer++;
+}
+
+static inline void gui_stats_lock(int64_t held_us, bool gui)
+{
+    if (gui) {
+        gui_stats.lock_us += held_us;
+        gui_stats.lock_count++;
+        if (held_us > gui_stats.lock_us_max) gui_stats.lock_us_max = held_us;
+        if (held_us > CONFIG_TUX_GUI_STALL_MS * 1000LL) gui_stats.stalls++;
+    } else {
+        gui_stats.lock_other_us += held_us;
+        gui_stats.lock_other_count++;
+        if (held_us > gui_stats.lock_other_us_max) gui_stats.lock_other_us_max = held_us;
+    }
+}
+
+static void gui_stats_report()
+{
+    int64_t window_us = esp_timer_get_time() - gui_stats.since;
+    if (window_us <= 0) return;
+
+    ESP_LOGI(TAG, "gui_task idle:%.1f%% wakeups timer:%" PRIu32 " event:%" PRIu32
+                  " lock avg:%" PRIu32 "us max:%" PRIu32 "us stalls:%" PRIu32 ", other tasks avg:%" PRIu32 "us max:%" PRIu32 "us",
+                100.0f * gui_stats.idle_us / window_us,
+                gui_stats.wakeups_timer, gui_stats.wakeups_event,
+                gui_stats.lock_count ? (uint32_t)(gui_stats.lock_us / gui_stats.lock_count) : 0,
+                gui_stats.lock_us_max, gui_stats.stalls,
+                gui_stats.lock_other_count ? (uint32_t)(gui_stats.lock_other_us / gui_stats.lock_other_count) : 0,
+                gui_stats.lock_other_us_max);
+
+    memset(&gui_stats, 0, sizeof(gui_stats));
+    gui_stats.since = esp_timer_get_time();
+}
+
+#endif // TUX_HELPER_PERF_H_
@@ -0,0 +1,196 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/*
+    Cross-task UI message queue
+    esp_event handlers, OTA and other tasks must not call lv_msg_send() or
+    touch lv_timers directly - LVGL is not thread safe. They post a typed
+    message here instead (no lock, no heap), gui_task drains the queue once
+    per loop while holding the LVGL lock and forwards it with lv_msg_send().
+
+    The queue itself is MpscQueue (helper_mpsc_queue.hpp). Payload is copied
+    into the slot, so stack buffers of the sender can go away right after
+    posting.
+*/
+
+#ifndef TUX_HELPER_UI_QUEUE_H_
+#define TUX_HELPER_UI_QUEUE_H_
+
+#include <atomic>
+#include <time.h>
+#include "helper_mpsc_queue.hpp"
+
+#define UI_MSG_TEXT_LEN 150
+
+typedef enum {
+    UI_PAYLOAD_NONE = 0,
+    UI_PAYLOAD_TM,
+    UI_PAYLOAD_INT,
+    UI_PAYLOAD_BOOL,
+    UI_PAYLOAD_TEXT,
+    UI_PAYLOAD_PTR,
+} ui_payload_t;
+
+typedef struct {
+    uint32_t id;                    // lv_msg id (MSG_xxx)
+    ui_payload_t type;
+    union {
+        struct tm tm;
+        int value;
+        bool flag;
+        char text[UI_MSG_TEXT_LEN];
+        void *ptr;
+    };
+} ui_msg_t;
+
+typedef struct {
+    std::atomic<uint32_t> posted;
+    std::atomic<uint32_t> dropped;      // queue was full
+    uint32_t delivered;
+    uint32_t coalesced;                 // superseded by a newer message with the same id in the same batch
+    uint32_t high_water;
+} ui_queue_stats_t;
+
+static MpscQueue<ui_msg_t, CONFIG_TUX_UI_QUEUE_DEPTH> ui_queue;
+static ui_queue_stats_t ui_queue_stats;
+
+static void gui_task_wake();
+
+static bool ui_post(const ui_msg_t &msg)
+{
+    ui_queue_stats.posted++;
+    if (!ui_queue.push(msg)) {
+        ui_queue_stats.dropped++;
+        return false;
+    }
+    gui_task_wake();
+    return true;
+}
+
+static bool ui_post(uint32_t id)
+{
+    ui_msg_t msg;
+    msg.id = id;
+    msg.type = UI_PAYLOAD_NONE;
+    msg.ptr = NULL;
+    return ui_post(msg);
+}
+
+static bool ui_post_tm(uint32_t id, const struct tm *tm)
+{
+    ui_msg_t msg;
+    msg.id = id;
+    msg.type = UI_PAYLOAD_TM;
+    msg.tm = *tm;
+    return ui_post(msg);
+}
+
+static bool ui_post_int(uint32_t id, int value)
+{
+    ui_msg_t msg;
+    msg.id = id;
+    msg.type = UI_PAYLOAD_INT;
+    msg.value = value;
+    return ui_post(msg);
+}
+
+static bool ui_post_bool(uint32_t id, bool flag)
+{
+    ui_msg_t msg;
+    msg.id = id;
+    msg.type = UI_PAYLOAD_BOOL;
+    msg.flag = flag;
+    return ui_post(msg);
+}
+
+static bool ui_post_text(uint32_t id, const char *text)
+{
+    ui_msg_t msg;
+    msg.id = id;
+    msg.type = UI_PAYLOAD_TEXT;
+    snprintf(msg.text, sizeof(msg.text), "%s", text ? text : "");
+    return ui_post(msg);
+}
+
+// Pointer payload must outlive the message (globals, lv_timer etc.)
+static bool ui_post_ptr(uint32_t id, void *ptr)
+{
+    ui_msg_t msg;
+    msg.id = id;
+    msg.type = UI_PAYLOAD_PTR;
+    msg.ptr = ptr;
+    return ui_post(msg);
+}
+
+static void *ui_msg_payload(ui_msg_t *msg)
+{
+    switch (msg->type) {
+        case UI_PAYLOAD_TM:   return &msg->tm;
+        case UI_PAYLOAD_INT:  return &msg->value;
+        case UI_PAYLOAD_BOOL: return &msg->flag;
+        case UI_PAYLOAD_TEXT: return msg->text;
+        case UI_PAYLOAD_PTR:  return msg->ptr;
+        default:              return NULL;
+    }
+}
+
+/*
+    GUI task only, with the LVGL lock held.
+    Only the newest message per id (and pointer, for PTR payloads) of a
+    batch is delivered - older ones were already stale before rendering.
+*/
+static void ui_queue_drain()
+{
+    static ui_msg_t batch[CONFIG_TUX_UI_QUEUE_DEPTH];
+    uint32_t count = 0;
+
+    uint32_t pending = ui_queue.size();
+    if (pending > ui_queue_stats.high_water) ui_queue_stats.high_water = pending;
+
+    while (count < CONFIG_TUX_UI_QUEUE_DEPTH && ui_queue.pop(batch[count])) count++;
+
+    for (uint32_t i = 0; i < count; i++) {
+        bool superseded = false;
+        for (uint32_t j = i + 1; j < count && !superseded; j++) {
+            superseded = batch[j].id == batch[i].id && batch[j].type == batch[i].type &&
+                         (batch[i].type != UI_PAYLOAD_PTR || batch[j].ptr == batch[i].ptr);
+        }
+        if (superseded) {
+            ui_queue_stats.coalesced++;
+            continue;
+        }
+        lv_msg_send(batch[i].id, ui_msg_payload(&batch[i]));
+        ui_queue_stats.delivered++;
+    }
+}
+
+static void ui_queue_report()
+{
+    ESP_LOGI(TAG, "ui_queue posted:%" PRIu32 " delivered:%" PRIu32 " coalesced:%" PRIu32 " dropped:%" PRIu32 " high water:%" PRIu32 "/%d",
+                ui_queue_stats.posted.load(), ui_queue_stats.delivered, ui_queue_stats.coalesced,
+                ui_queue_stats.dropped.load(), ui_queue_stats.high_water, CONFIG_TUX_UI_QUEUE_DEPTH);
+}
+
+#endif // TUX_HELPER_UI_QUEUE_H_
@@ -0,0 +1,163 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/*
+    Latest-value-wins UI state channel
+    For status that is overwritten faster than it is worth rendering - clock,
+    battery, OTA progress. One slot per msg id holds only the newest value,
+    producers overwrite it (no queueing, nothing to drop) and gui_task
+    delivers each changed slot once per loop with lv_msg_send().
+
+    Each slot is a seqlock - odd sequence while a producer is writing, the
+    GUI task retries the copy if the sequence moved underneath it.
+    Use the same channel for every message of an id, mixing it with
+    ui_post() would let an older queued value overtake a newer state.
+*/
+
+#ifndef TUX_HELPER_UI_STATE_H_
+#define TUX_HELPER_UI_STATE_H_
+
+#include <atomic>
+#include "helper_ui_queue.hpp"
+
+#define UI_STATE_SLOTS      8
+
+typedef struct {
+    std::atomic<uint32_t> key;      // msg id + 1, 0 => free slot
+    std::atomic<uint32_t> seq;      // odd => write in progress
+    std::atomic<bool> pending;      // new value not delivered yet
+    ui_msg_t value;
+} ui_state_slot_t;
+
+typedef struct {
+    std::atomic<uint32_t> updates;
+    std::atomic<uint32_t> superseded;   // overwritten before gui_task delivered it
+    uint32_t delivered;
+    uint32_t redraws_avoided;           // label/icon updates skipped, nothing visible changed
+} ui_state_stats_t;
+
+static ui_state_slot_t ui_state_slots[UI_STATE_SLOTS];
+static ui_state_stats_t ui_state_stats;
+
+// Slot of the msg id, claimed on first use
+static ui_state_slot_t *ui_state_slot(uint32_t id)
+{
+    uint32_t key = id + 1;
+    for (int i = 0; i < UI_STATE_SLOTS; i++) {
+        uint32_t slot_key = ui_state_slots[i].key.load(std::memory_order_acquire);
+        if (slot_key == key) return &ui_state_slots[i];
+        if (slot_key == 0) {
+            uint32_t expected = 0;
+            if (ui_state_slots[i].key.compare_exchange_strong(expected, key) || expected == key)
+                return &ui_state_slots[i];
+        }
+    }
+    ESP_LOGE(TAG, "ui_state: no free slot for msg %" PRIu32, id);
+    return NULL;
+}
+
+// Any task
+static bool ui_state_set(const ui_msg_t &msg)
+{
+    ui_state_slot_t *slot = ui_state_slot(msg.id);
+    if (slot == NULL) return false;
+
+    // Take the write side: even -> odd (several producers may update the same id)
+    uint32_t seq = slot->seq.load(std::memory_order_relaxed);
+    for (;;) {
+        if ((seq & 1) == 0 && slot->seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire)) break;
+        if (seq & 1) {
+            taskYIELD();
+            seq = slot->seq.load(std::memory_order_relaxed);
+        }
+    }
+    slot->value = msg;
+    slot->seq.store(seq + 2, std::memory_order_release);
+
+    ui_state_stats.updates++;
+    if (slot->pending.exchange(true)) ui_state_stats.superseded++;
+    gui_task_wake();
+    return true;
+}
+
+static bool ui_state_set_int(uint32_t id, int value)
+{
+    ui_msg_t msg;
+    msg.id = id;
+    msg.type = UI_PAYLOAD_INT;
+    msg.value = value;
+    return ui_state_set(msg);
+}
+
+static bool ui_state_set_tm(uint32_t id, const struct tm *tm)
+{
+    ui_msg_t msg;
+    msg.id = id;
+    msg.type = UI_PAYLOAD_TM;
+    msg.tm = *tm;
+    return ui_state_set(msg);
+}
+
+static bool ui_state_set_text(uint32_t id, const char *text)
+{
+    ui_msg_t msg;
+    msg.id = id;
+    msg.type = UI_PAYLOAD_TEXT;
+    snprintf(msg.text, sizeof(msg.text), "%s", text ? text : "");
+    return ui_state_set(msg);
+}
+
+// GUI task only, with the LVGL lock held
+static void ui_state_drain()
+{
+    static ui_msg_t value;
+
+    for (int i = 0; i < UI_STATE_SLOTS; i++) {
+        ui_state_slot_t *slot = &ui_state_slots[i];
+        if (slot->key.load(std::memory_order_relaxed) == 0) break;     // slots are claimed in order
+        if (!slot->pending.exchange(false)) continue;
+
+        uint32_t before, after;
+        do {
+            before = slot->seq.load(std::memory_order_acquire);
+            if (before & 1) { taskYIELD(); continue; }
+            value = slot->value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = slot->seq.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        lv_msg_send(value.id, ui_msg_payload(&value));
+        ui_state_stats.delivered++;
+    }
+}
+
+static void ui_state_report()
+{
+    ESP_LOGI(TAG, "ui_state updates:%" PRIu32 " delivered:%" PRIu32 " superseded:%" PRIu32 " redraws avoided:%" PRIu32,
+                ui_state_stats.updates.load(), ui_state_stats.delivered,
+                ui_state_stats.superseded.load(), ui_state_stats.redraws_avoided);
+}
+
+#endif // TUX_HELPER_UI_STATE_H_
@@ -0,0 +1,162 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+    Background workers for network and storage jobs
+    lv_timer callbacks run inside lv_timer_handler() with the LVGL lock held,
+    anything slow there (HTTP, flash writes) freezes touch and rendering.
+    They submit a job here instead - a function and an argument copied into
+    a FreeRTOS queue - and one of a few worker tasks runs it. Results go back
+    to the UI through ui_post()/ui_state_set() like from any other task.
+
+    Jobs with a key run one at a time: submitting a key that is still queued
+    or running doesn't queue it twice, the job just runs once more after the
+    current run is done (so a settings save requested meanwhile isn't lost).
+*/
+
+#ifndef TUX_HELPER_WORKER_H_
+#define TUX_HELPER_WORKER_H_
+
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+
+// Job keys - one bit each, 0 for jobs that may run in parallel
+#define WORKER_KEY_WEATHER      (1u << 0)
+#define WORKER_KEY_SETTINGS     (1u << 1)
+#define WORKER_KEY_DEVICE_INFO  (1u << 2)
+
+typedef void (*worker_fn_t)(void *arg);
+
+typedef struct {
+    worker_fn_t fn;
+    void *arg;
+    const char *name;
+    uint32_t key;
+    int64_t queued_at;
+} worker_job_t;
+
+typedef struct {
+    std::atomic<uint32_t> submitted;
+    std::atomic<uint32_t> coalesced;    // key already queued or running
+    std::atomic<uint32_t> dropped;      // queue was full
+    std::atomic<uint32_t> done;
+    uint32_t wait_us_max;               // queued -> started
+    uint32_t run_us_max;
+    const char *slowest;                // job behind run_us_max
+} worker_stats_t;
+
+static QueueHandle_t worker_queue = NULL;
+static worker_stats_t worker_stats;
+static std::atomic<uint32_t> worker_busy_keys(0);    // queued or running
+static std::atomic<uint32_t> worker_again_keys(0);   // submitted again while busy
+static portMUX_TYPE worker_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool worker_enqueue(const worker_job_t &job)
+{
+    if (worker_queue && xQueueSend(worker_queue, &job, 0) == pdTRUE) return true;
+    worker_stats.dropped++;
+    if (job.key) {
+        worker_busy_keys.fetch_and(~job.key);
+        worker_again_keys.fetch_and(~job.key);
+    }
+    ESP_LOGW(TAG, "Worker queue full, %s dropped", job.name);
+    return false;
+}
+
+// Any task, never blocks. Pointer arguments must outlive the job.
+static bool worker_submit(const char *name, worker_fn_t fn, void *arg = NULL, uint32_t key = 0)
+{
+    worker_stats.submitted++;
+    if (key && (worker_busy_keys.fetch_or(key) & key)) {
+        worker_again_keys.fetch_or(key);
+        worker_stats.coalesced++;
+        return true;
+    }
+
+    worker_job_t job = { fn, arg, name, key, esp_timer_get_time() };
+    return worker_enqueue(job);
+}
+
+static void worker_task(void *args)
+{
+    worker_job_t job;
+    while (1) {
+        if (xQueueReceive(worker_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+
+        int64_t start = esp_timer_get_time();
+        job.fn(job.arg);
+        int64_t end = esp_timer_get_time();
+
+        taskENTER_CRITICAL(&worker_stats_lock);
+        if (start - job.queued_at > worker_stats.wait_us_max) worker_stats.wait_us_max = start - job.queued_at;
+        if (end - start > worker_stats.run_us_max) {
+            worker_stats.run_us_max = end - start;
+            worker_stats.slowest = job.name;
+        }
+        taskEXIT_CRITICAL(&worker_stats_lock);
+        worker_stats.done++;
+
+        if (job.key) {
+            // Asked for again while running - one more run picks up the latest state
+            if (worker_again_keys.fetch_and(~job.key) & job.key) {
+                job.queued_at = esp_timer_get_time();
+                worker_enqueue(job);
+            } else {
+                worker_busy_keys.fetch_and(~job.key);
+            }
+        }
+    }
+}
+
+static void worker_init()
+{
+    if (worker_queue) return;
+    worker_queue = xQueueCreate(CONFIG_TUX_WORKER_QUEUE_DEPTH, sizeof(worker_job_t));
+    for (int i = 0; i < CONFIG_TUX_WORKER_COUNT; i++) {
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "worker_%d", i);
+        xTaskCreate(worker_task, name, CONFIG_TUX_WORKER_STACK, NULL, 3, NULL);
+    }
+    ESP_LOGI(TAG, "%d workers started, queue depth %d", CONFIG_TUX_WORKER_COUNT, CONFIG_TUX_WORKER_QUEUE_DEPTH);
+}
+
+static void worker_report()
+{
+    ESP_LOGI(TAG, "workers submitted:%" PRIu32 " done:%" PRIu32 " coalesced:%" PRIu32 " dropped:%" PRIu32
+                  " wait max:%" PRIu32 "us run max:%" PRIu32 "us (%s)",
+                worker_stats.submitted.load(), worker_stats.done.load(), worker_stats.coalesced.load(),
+                worker_stats.dropped.load(), worker_stats.wait_us_max, worker_stats.run_us_max,
+                worker_stats.slowest ? worker_stats.slowest : "-");
+
+    taskENTER_CRITICAL(&worker_stats_lock);
+    worker_stats.wait_us_max = 0;
+    worker_stats.run_us_max = 0;
+    worker_stats.slowest = NULL;
+    taskEXIT_CRITICAL(&worker_stats_lock);
+}
+
+#endif // TUX_HELPER_WORKER_H_
@@ -52,8 +52,8 @@ static void update_datetime_ui()
         return;
     }
 
-    // Send update time to UI with payload using lv_msg
-    lv_msg_send(MSG_TIME_CHANGED, &datetimeinfo);
+    // Latest time wins, UI gets only the newest value per frame (copied, any task)
+    ui_state_set_tm(MSG_TIME_CHANGED, &datetimeinfo);
 }
 
 static const char* get_id_string(esp_event_base_t base, int32_t id) {
@@ -99,47 +99,50 @@ static void tux_event_handler(void* arg, esp_event_base_t event_base,
         update_datetime_ui();
 
         // Enable timer after the date/time is set.
-        lv_timer_ready(timer_weather); 
+        ui_post_ptr(MSG_TIMER_READY, timer_weather);
 
     } else if (event_id == TUX_EVENT_OTA_STARTED) {
         // OTA Started
-        char buffer[150] = {0};
+        char buffer[UI_MSG_TEXT_LEN] = {0};
         snprintf(buffer,sizeof(buffer),"OTA: %s",(char*)event_data);
-        lv_msg_send(MSG_OTA_STATUS,buffer);
+        ui_state_set_text(MSG_OTA_STATUS,buffer);
 
     } else if (event_id == TUX_EVENT_OTA_IN_PROGRESS) {
-        // OTA In Progress - progressbar?
-        char buffer[150] = {0};
-        int bytes_read = (*(int *)event_data)/1024;
-        snprintf(buffer,sizeof(buffer),"OTA: Data read : %dkb", bytes_read);
-        lv_msg_send(MSG_OTA_STATUS,buffer);
+        // OTA In Progress - posted only when the percentage changes
+        char buffer[UI_MSG_TEXT_LEN] = {0};
+        ota_progress_t *progress = (ota_progress_t *)event_data;
+        if (progress->percent >= 0)
+            snprintf(buffer,sizeof(buffer),"OTA: Downloading %d%% (%dkb)", progress->percent, progress->bytes_read/1024);
+        else
+            snprintf(buffer,sizeof(buffer),"OTA: Data read : %dkb", progress->bytes_read/1024);
+        ui_state_set_text(MSG_OTA_STATUS,buffer);
 
     } else if (event_id == TUX_EVENT_OTA_ROLLBACK) {
         // OTA Rollback - god knows why!
-        char buffer[150] = {0};
+        char buffer[UI_MSG_TEXT_LEN] = {0};
         snprintf(buffer,sizeof(buffer),"OTA: %s", (char*)event_data);
-        lv_msg_send(MSG_OTA_STATUS,buffer);
+        ui_state_set_text(MSG_OTA_STATUS,buffer);
 
     } else if (event_id == TUX_EVENT_OTA_COMPLETED) {
         // OTA Completed - YAY! Success
-        char buffer[150] = {0};
+        char buffer[UI_MSG_TEXT_LEN] = {0};
         snprintf(buffer,sizeof(buffer),"OTA: %s", (char*)event_data);
-        lv_msg_send(MSG_OTA_STATUS,buffer);
+        ui_state_set_text(MSG_OTA_STATUS,buffer);
 
         // wait before reboot
         vTaskDelay(3000 / portTICK_PERIOD_MS);
 
     } else if (event_id == TUX_EVENT_OTA_ABORTED) {
         // OTA Aborted - Not a good day for updates
-        char buffer[150] = {0};
+        char buffer[UI_MSG_TEXT_LEN] = {0};
         snprintf(buffer,sizeof(buffer),"OTA: %s", (char*)event_data);
-        lv_msg_send(MSG_OTA_STATUS,buffer);
+        ui_state_set_text(MSG_OTA_STATUS,buffer);
 
     } else if (event_id == TUX_EVENT_OTA_FAILED) {
         // OTA Failed - huh! - maybe in red color?
-        char buffer[150] = {0};
+        char buffer[UI_MSG_TEXT_LEN] = {0};
         snprintf(buffer,sizeof(buffer),"OTA: %s", (char*)event_data);
-        lv_msg_send(MSG_OTA_STATUS,buffer);
+        ui_state_set_text(MSG_OTA_STATUS,buffer);
 
     } else if (event_id == TUX_EVENT_WEATHER_UPDATED) {
         // Weather updates - summer?
@@ -157,32 +160,35 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
     if (event_base == WIFI_EVENT  && event_id == WIFI_EVENT_STA_CONNECTED)
     {
         is_wifi_connected = true;
-        lv_timer_ready(timer_datetime);   // start timer
+        ui_post_ptr(MSG_TIMER_READY, timer_datetime);   // start timer
 
         // After OTA device restart, RTC will have time but not timezone
         set_timezone();
 
         // Not a warning but just for highlight
         ESP_LOGW(TAG,"WIFI_EVENT_STA_CONNECTED");
-        lv_msg_send(MSG_WIFI_CONNECTED,NULL);
+        ui_post(MSG_WIFI_CONNECTED);
     }
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
     {
         is_wifi_connected = false;        
-        lv_timer_pause(timer_datetime);   // stop/pause timer
+        ui_post_ptr(MSG_TIMER_PAUSE, timer_datetime);   // stop/pause timer
 
         ESP_LOGW(TAG,"WIFI_EVENT_STA_DISCONNECTED");
-        lv_msg_send(MSG_WIFI_DISCONNECTED,NULL);
+        ui_post(MSG_WIFI_DISCONNECTED);
+
+        HttpPool::instance().close_all();   // kept-alive sockets are dead now
     }
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
     {
         is_wifi_connected = true;
-        lv_timer_ready(timer_datetime);   // start timer
+        ui_post_ptr(MSG_TIMER_READY, timer_datetime);   // start timer
 
         ESP_LOGW(TAG,"IP_EVENT_STA_GOT_IP");
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
 
         snprintf(ip_payload,sizeof(ip_payload),"%d.%d.%d.%d", IP2STR(&event->ip_info.ip));
+        HttpPool::instance().flush_dns();   // may be a different network / DNS server
         
         // We got IP, lets update time from SNTP. RTC keeps time unless powered off
         xTaskCreate(configure_time, "config_time", 1024*4, NULL, 3, NULL);
@@ -220,10 +226,13 @@ extern "C" void app_main(void)
     //esp_log_level_set("SettingsConfig", ESP_LOG_DEBUG);    
     esp_log_level_set("wifi", ESP_LOG_WARN);    // enable WARN logs from WiFi stack
 
+    int boot_total = boot_begin("boot");
+
     // Print device info
     ESP_LOGE(TAG,"\n%s",device_info().c_str());
 
     //Initialize NVS
+    int phase = boot_begin("nvs");
     esp_err_t err = nvs_flash_init();
 
     // NVS partition contains new data format or unable to access
@@ -232,48 +241,40 @@ extern "C" void app_main(void)
         err = nvs_flash_init();
     }
     ESP_ERROR_CHECK(err); 
+    boot_end(phase);
 
-    // Init SPIFF - needed for lvgl images
+    // Init SPIFF - needed for lvgl images, the splash logo included
+    phase = boot_begin("spiffs");
     init_spiff();
+    boot_end(phase);
 
-#ifdef SD_SUPPORTED
-    // Initializing SDSPI 
-    if (init_sdspi() == ESP_OK) // SD SPI
-    {
-        is_sdcard_enabled = true;
-    }
-#endif   
-//********************** CONFIG HELPER TESTING STARTS
+    // Settings, weather cache - only needed once the main UI gets built
+    boot_run("settings", boot_settings, BOOT_SETTINGS_DONE);
 
-     //cfg = new SettingsConfig("/sdcard/settings.json");    // yet to test
-    cfg = new SettingsConfig("/spiffs/settings.json");
-    // Save settings
-    cfg->save_config();   // save default loaded settings
-    // Load values
-    cfg->load_config();
-    // Change device name
-    cfg->DeviceName = "ESP32-TUX";
-    cfg->WeatherAPIkey = CONFIG_WEATHER_API_KEY;
-    cfg->WeatherLocation = CONFIG_WEATHER_LOCATION;
-    cfg->WeatherProvider = CONFIG_WEATHER_OWM_URL;
-    // Change brightness
-    cfg->Brightness=250;
-    // Save settings again
-    cfg->save_config();
-    cfg->load_config();
+    // Wallpaper into PSRAM while the display comes up
+    asset_init();
+    boot_run("assets", boot_assets, BOOT_ASSETS_DONE);
 
-//******************************************** 
-    owm = new OpenWeatherMap();
-//********************** CONFIG HELPER TESTING ENDS
+#ifdef SD_SUPPORTED
+  #if defined(WT32_SC01)
+    // Shares the SPI bus with the display, mount before the panel is set up
+    boot_run("sdcard", boot_sdcard, BOOT_SDCARD_DONE, false);
+  #else
+    boot_run("sdcard", boot_sdcard, BOOT_SDCARD_DONE);
+  #endif
+#endif   
 
+    phase = boot_begin("display");
     lcd.init();         // Initialize LovyanGFX
     lcd.initDMA();      // Init DMA
     lv_init();          // Initialize lvgl
+    lv_fs_cache_init(); // Block cache in front of the F: / S: drivers
 
     if (lv_display_init() != ESP_OK) // Configure LVGL
     {
         ESP_LOGE(TAG, "LVGL setup failed!!!");
     }
+    boot_end(phase);
 
     // /* Initialize the event loop */
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -288,33 +289,53 @@ extern "C" void app_main(void)
     // TUX EVENTS
     ESP_ERROR_CHECK(esp_event_handler_instance_register(TUX_EVENTS, ESP_EVENT_ANY_ID, tux_event_handler, NULL, NULL));
 
-    // LV_FS integration & print readme.txt from the root for testing
-    lv_print_readme_txt("F:/readme.txt");   // SPIFF / FAT
-    lv_print_readme_txt("S:/readme.txt");   // SDCARD
+    // Wifi Provision and connection.
+    // Use idf.py menuconfig to configure 
+    // Use SoftAP only / BLE has some issues
+    // Tuning PSRAM options visible only in IDF5, so will wait till then for BLE.
+    // Started after the display so the draw buffers get their DMA memory first,
+    // netif/wifi init then runs while the splash and the UI are built.
+    xTaskCreate(provision_wifi, "wifi_prov", 1024*8, NULL, 3, NULL);
 
-/* Push LVGL/UI to its own UI task later*/
-    // Splash screen
+    // Splash screen - rendered right away, the main UI takes a while
+    phase = boot_begin("splash");
     lvgl_acquire();
     create_splash_screen();
+    lv_refr_now(NULL);
     lvgl_release();
+    boot_end(phase);
+    boot_splash_shown();
+
+#ifdef SD_SUPPORTED
+    boot_wait(BOOT_SETTINGS_DONE | BOOT_ASSETS_DONE | BOOT_SDCARD_DONE);
+#else
+    boot_wait(BOOT_SETTINGS_DONE | BOOT_ASSETS_DONE);
+#endif
+    lcd.setBrightness(cfg->Brightness);     // last value from the settings page
+    // UI changes are saved after the debounce window on a worker
+    cfg->set_dispatcher(settings_dispatch);
+    // Refreshes run on a worker, the UI reads the values under the LVGL lock
+    OpenWeatherMap::set_apply_lock(lvgl_acquire, lvgl_release);
+
+    // LV_FS integration & print readme.txt from the root for testing
+    lv_print_readme_txt("F:/readme.txt");   // SPIFF / FAT
+    lv_print_readme_txt("S:/readme.txt");   // SDCARD
 
     // Main UI
+    phase = boot_begin("ui");
     lvgl_acquire();
     lv_setup_styles();    
     show_ui();
     lvgl_release();
-/* Push these to its own UI task later*/
+    boot_end(phase);
 
 #ifdef SD_SUPPORTED
     // Icon status color update
-    lv_msg_send(MSG_SDCARD_STATUS,&is_sdcard_enabled);
+    ui_post_bool(MSG_SDCARD_STATUS,is_sdcard_enabled);
 #endif
 
-    // Wifi Provision and connection.
-    // Use idf.py menuconfig to configure 
-    // Use SoftAP only / BLE has some issues
-    // Tuning PSRAM options visible only in IDF5, so will wait till then for BLE.
-    xTaskCreate(provision_wifi, "wifi_prov", 1024*8, NULL, 3, NULL);
+    // Network and storage jobs, keeps them out of lv_timer_handler()
+    worker_init();
 
     ESP_LOGI(TAG, "[APP] Free memory: %" PRIu32 " bytes", esp_get_free_heap_size());
 
@@ -322,7 +343,7 @@ extern "C" void app_main(void)
     timer_datetime = lv_timer_create(timer_datetime_callback, 1000,  NULL);
     //lv_timer_pause(timer_datetime); // enable only when wifi is connected
 
-    // Weather update timer - Once per min (60*1000) or maybe once in 10 mins (10*60*1000)
+    // Weather poll timer - period follows the engine's schedule
     timer_weather = lv_timer_create(timer_weather_callback, WEATHER_UPDATE_INTERVAL,  NULL);
 
     //lv_timer_set_repeat_count(timer_weather,1);
@@ -335,6 +356,65 @@ extern "C" void app_main(void)
     lv_msg_subsribe(MSG_PAGE_SETTINGS, tux_ui_change_cb, NULL);
     lv_msg_subsribe(MSG_PAGE_OTA, tux_ui_change_cb, NULL);
     lv_msg_subsribe(MSG_OTA_INITIATE, tux_ui_change_cb, NULL);    // Initiate OTA
+
+    // Timer start/stop requested by other tasks through the UI queue
+    lv_msg_subsribe(MSG_TIMER_READY, tux_timer_ctrl_cb, NULL);
+    lv_msg_subsribe(MSG_TIMER_PAUSE, tux_timer_ctrl_cb, NULL);
+
+    boot_end(boot_total);
+    boot_report();
+    asset_report();
+    font_store_report();
+
+#if defined(CONFIG_TUX_UI_BENCHMARK)
+    // Frame time benchmark for all the pages, results over serial
+    xTaskCreate(ui_benchmark_task, "ui_benchmark", 1024*4, NULL, 3, NULL);
+#endif
+}
+
+// Boot phase - settings and weather cache from SPIFFS/NVS
+static void boot_settings()
+{
+     //cfg = new SettingsConfig("/sdcard/settings.json");    // yet to test
+#if defined(CONFIG_TUX_SETTINGS_NVS)
+    cfg = new SettingsConfig("nvs:tux");
+#else
+    cfg = new SettingsConfig("/spiffs/settings.json");
+#endif
+    // Load values - defaults if nothing is stored yet
+    cfg->load_config();
+    // Change device name
+    cfg->DeviceName = "ESP32-TUX";
+    cfg->WeatherAPIkey = CONFIG_WEATHER_API_KEY;
+    cfg->WeatherLocation = CONFIG_WEATHER_LOCATION;
+    cfg->WeatherProvider = CONFIG_WEATHER_OWM_URL;
+    // Written only if a persisted value changed (first boot, new device name)
+    cfg->save_config();
+    cfg->report();
+
+    weather = new WeatherEngine();
+    weather->set_listener(weather_changed_cb, NULL);
+    owm = weather->current(0);
+}
+
+// Boot phase - images used by every page, no LVGL calls
+static void boot_assets()
+{
+#if defined(CONFIG_WALLPAPER_IMAGE)
+    asset_load(TUX_WALLPAPER, false);
+#endif
+}
+
+// Boot phase - SD card mount
+static void boot_sdcard()
+{
+#ifdef SD_SUPPORTED
+    // Initializing SDSPI 
+    if (init_sdspi() == ESP_OK) // SD SPI
+    {
+        is_sdcard_enabled = true;
+    }
+#endif
 }
 
 static void timer_datetime_callback(lv_timer_t * timer)
@@ -343,20 +423,55 @@ static void timer_datetime_callback(lv_timer_t * timer)
     if (battery_value>100) battery_value=0;
     battery_value+=10;
     
-    lv_msg_send(MSG_BATTERY_STATUS,&battery_value);
+    ui_state_set_int(MSG_BATTERY_STATUS,battery_value);
     update_datetime_ui();
 }
 
 static void timer_weather_callback(lv_timer_t * timer)
 {
+#if !defined(CONFIG_WEATHER_USE_LOCAL_SERVER)   // mock server needs no key
     if (cfg->WeatherAPIkey.empty()) {   // If API key not defined skip weather update
         ESP_LOGW(TAG,"Weather API Key not set");
         return;
     }
+#endif
+
+    // Refresh whatever is due on a worker, UI update comes through weather_changed_cb
+    worker_submit("weather_poll", weather_poll_job, timer, WORKER_KEY_WEATHER);
+}
 
-    // Update weather and trigger UI update
-    owm->request_weather_update();
-    lv_msg_send(MSG_WEATHER_CHANGED, owm);
+// Worker task - HTTP requests and cache writes, the LVGL lock is only taken to apply results
+static void weather_poll_job(void *arg)
+{
+    lv_timer_t *timer = (lv_timer_t *)arg;
+    uint32_t next_ms = weather->poll();
+
+    lvgl_acquire();
+    lv_timer_set_period(timer, next_ms);
+    lvgl_release();
+}
+
+// Engine has new values - only the home page location is on screen
+static void weather_changed_cb(int location, uint32_t changed, void *ctx)
+{
+    LV_UNUSED(ctx);
+    ESP_LOGD(TAG,"Weather location %d changed 0x%08" PRIx32, location, changed);
+    if (location == 0) ui_post_ptr(MSG_WEATHER_CHANGED, owm);
+}
+
+// lv_timer control posted from other tasks, runs in gui_task
+static void tux_timer_ctrl_cb(void * s, lv_msg_t *m)
+{
+    LV_UNUSED(s);
+    lv_timer_t *timer = (lv_timer_t *)lv_msg_get_payload(m);
+    if (timer == NULL) return;
+
+    if (lv_msg_get_id(m) == MSG_TIMER_READY) {
+        lv_timer_resume(timer);
+        lv_timer_ready(timer);
+    } else {
+        lv_timer_pause(timer);
+    }
 }
 
 // Callback to notify App UI change
@@ -388,11 +503,12 @@ static void tux_ui_change_cb(void * s, lv_msg_t *m)
             }
             break;
         case MSG_PAGE_OTA:
-            // Update firmware current version info
-            lv_msg_send(MSG_DEVICE_INFO,device_info().c_str());
+            // Update firmware current version info - flash/partition reads on a worker
+            worker_submit("device_info", device_info_job, NULL, WORKER_KEY_DEVICE_INFO);
             break;
         case MSG_OTA_INITIATE:
             // OTA update from button trigger
+            cfg->flush();   // pending settings save, OTA ends with a reboot
             xTaskCreate(run_ota_task, "run_ota_task", 1024 * 8, NULL, 5, NULL);
             break;
     }
@@ -442,6 +558,47 @@ static string device_info()
                                                     (chip_info.features & CHIP_FEATURE_BLE) ? "/BLE" : "");
     //s_chip_info += fmt::format("\nIEEE 802.15.4 : {}",string((chip_info.features & CHIP_FEATURE_IEEE802154) ? "YES" : "NA"));
 
+    // LVGL memory - pool or heap allocator (not available before lv_init)
+    if (lv_is_initialized()) {
+        tux_lv_mem_t mem;
+        lvgl_acquire();     // may run on a worker
+        lv_mem_usage(&mem);
+        lvgl_release();
+        s_chip_info += fmt::format("\nLVGL Memory  : {}KB peak {}KB frag {}%\n",
+                                    mem.used / 1024, mem.peak / 1024, mem.frag_pct);
+#if LV_MEM_CUSTOM
+        tux_mem_stats_t st;
+        tux_mem_get_stats(&st);
+        s_chip_info += fmt::format("LVGL Heap    : {}KB int {}KB psram\n",
+                                    st.used_internal / 1024, st.used_psram / 1024);
+        s_chip_info += fmt::format("LVGL Allocs  : {} live {} failed\n", st.live, st.failed);
+#else
+        s_chip_info += fmt::format("LVGL Pool    : {}KB free of {}KB\n", mem.free / 1024, LV_MEM_SIZE / 1024);
+#endif
+    }
+
+    // Startup phases, once app_main is through
+    string timeline = boot_timeline();
+    if (!timeline.empty()) s_chip_info += "\nBoot timeline\n" + timeline;
+
     //ESP_LOGE(TAG,"\n%s",device_info().c_str());
     return s_chip_info;
+}
+
+// Settings writes requested by save_later() - off the esp_timer task
+static void settings_dispatch(void (*job)(void *arg), void *arg)
+{
+    worker_submit("settings_save", job, arg, WORKER_KEY_SETTINGS);
+}
+
+static void device_info_job(void *arg)
+{
+    LV_UNUSED(arg);
+    string info = device_info();
+
+    // gui_task reads devinfo_data while delivering the message
+    lvgl_acquire();
+    snprintf(devinfo_data, sizeof(devinfo_data), "%s", info.c_str());
+    lvgl_release();
+    ui_post_ptr(MSG_DEVICE_INFO, devinfo_data);
 }
\ No newline at end of file
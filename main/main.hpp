@@ -47,6 +47,8 @@ using namespace std ;
 
 #include "SettingsConfig.hpp"
 
+SettingsConfig *cfg;        // before gui.hpp, the settings page saves through it
+
 #include "wifi_prov_mgr.hpp"    // Provision and connect to Wifi
 #include "helper_sntp.hpp"      // Get and set device time
 
@@ -76,6 +78,11 @@ using namespace std ;
 /********************************************************/
 
 #include "helper_display.hpp"
+#include "helper_boot.hpp"
+#include "helper_assets.hpp"
+#include "helper_lv_fs_cache.hpp"
+#include "helper_glyph_cache.hpp"
+#include "helper_font_store.hpp"
 
 /* SD Card support */
 #if defined(SD_SUPPORTED)
@@ -93,18 +100,33 @@ using namespace std ;
 #include "events/tux_events.hpp"
 
 #include "OpenWeatherMap.hpp"
+#include "WeatherEngine.hpp"
+#include "HttpPool.hpp"
 #include "events/gui_events.hpp"
 
 /* Event source periodic timer related definitions */
 ESP_EVENT_DEFINE_BASE(TUX_EVENTS);
 
-SettingsConfig *cfg;
-OpenWeatherMap *owm;
+WeatherEngine *weather;
+OpenWeatherMap *owm;        // first location - the one on the home page
 
 static void timer_datetime_callback(lv_timer_t * timer);
 static void timer_weather_callback(lv_timer_t * timer);
+static void weather_changed_cb(int location, uint32_t changed, void *ctx);
+static void weather_poll_job(void *arg);
+static void device_info_job(void *arg);
+static void settings_dispatch(void (*job)(void *arg), void *arg);
+static void boot_settings();
+static void boot_sdcard();
+static void boot_assets();
+
+// Parallel boot phases app_main waits for
+#define BOOT_SETTINGS_DONE  BIT0
+#define BOOT_SDCARD_DONE    BIT1
+#define BOOT_ASSETS_DONE    BIT2
 static void lv_update_battery(uint batval);
 static void tux_ui_change_cb(void * s, lv_msg_t *m);
+static void tux_timer_ctrl_cb(void * s, lv_msg_t *m);
 
 static string device_info();
 
@@ -128,9 +150,9 @@ static lv_timer_t * timer_weather;
 char qr_payload[150] = {0};     // QR code data for WiFi provisioning
 char ip_payload[20] = {0};      // IP Address
 char ota_status[150] = {0};     // OTA status during updates
-char devinfo_data[300] = {0};   // Device info
+char devinfo_data[1024] = {0};  // Device info and boot timeline
 
-// Weather update timer - Once per min (60*1000) or maybe once in 10 mins (10*60*1000)
-static constexpr int WEATHER_UPDATE_INTERVAL = 60 * 1000;
+// First weather poll, after that the engine says when the next refresh is due
+static constexpr int WEATHER_UPDATE_INTERVAL = 5 * 1000;
 
 #endif // TUX_CONF_H
\ No newline at end of file
@@ -0,0 +1,171 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <string.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_heap_caps.h"
+#include "tux_mem.h"
+
+#if defined(CONFIG_TUX_LV_MEM_INTERNAL_MAX)
+#define TUX_MEM_INTERNAL_MAX CONFIG_TUX_LV_MEM_INTERNAL_MAX
+#else
+#define TUX_MEM_INTERNAL_MAX 256
+#endif
+
+#define CAPS_INTERNAL   (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define CAPS_PSRAM      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+
+// Block header in front of every allocation - keeps the stats exact on free
+typedef struct {
+    uint32_t size;              // Requested size
+    uint32_t psram;             // 1 if the block lives in PSRAM
+} tux_mem_hdr_t;
+
+_Static_assert(sizeof(tux_mem_hdr_t) == 8, "Header must keep 8 byte alignment");
+
+// LVGL only allocates with the LVGL lock held, so no locking here
+static tux_mem_stats_t stats;
+
+static int size_class(size_t size)
+{
+    int cls = 0;
+    size_t limit = 16;
+    while (cls < TUX_MEM_CLASSES - 1 && size > limit) {
+        limit <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+static void account(tux_mem_hdr_t *hdr, bool add)
+{
+    size_t *region = hdr->psram ? &stats.used_psram : &stats.used_internal;
+    if (add) {
+        stats.used += hdr->size;
+        *region += hdr->size;
+        stats.live++;
+        if (stats.used > stats.peak) stats.peak = stats.used;
+    } else {
+        stats.used -= hdr->size;
+        *region -= hdr->size;
+        stats.live--;
+    }
+}
+
+static tux_mem_hdr_t *raw_alloc(size_t size)
+{
+    bool small = size <= TUX_MEM_INTERNAL_MAX;
+    uint32_t first = small ? CAPS_INTERNAL : CAPS_PSRAM;
+    uint32_t second = small ? CAPS_PSRAM : CAPS_INTERNAL;
+
+    tux_mem_hdr_t *hdr = heap_caps_malloc(sizeof(tux_mem_hdr_t) + size, first);
+    bool psram = !small;
+    if (hdr == NULL) {
+        hdr = heap_caps_malloc(sizeof(tux_mem_hdr_t) + size, second);
+        psram = small;
+        if (hdr != NULL) stats.fallbacks++;
+    }
+    if (hdr == NULL) return NULL;
+
+    hdr->size = size;
+    hdr->psram = psram;
+    return hdr;
+}
+
+void *tux_mem_alloc(size_t size)
+{
+    tux_mem_hdr_t *hdr = raw_alloc(size);
+    if (hdr == NULL) {
+        stats.failed++;
+        return NULL;
+    }
+    stats.allocs++;
+    stats.by_class[size_class(size)]++;
+    account(hdr, true);
+    return hdr + 1;
+}
+
+void tux_mem_free(void *ptr)
+{
+    if (ptr == NULL) return;
+    tux_mem_hdr_t *hdr = (tux_mem_hdr_t *)ptr - 1;
+    account(hdr, false);
+    stats.frees++;
+    heap_caps_free(hdr);
+}
+
+void *tux_mem_realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL) return tux_mem_alloc(size);
+    if (size == 0) {
+        tux_mem_free(ptr);
+        return NULL;
+    }
+
+    tux_mem_hdr_t *hdr = (tux_mem_hdr_t *)ptr - 1;
+    tux_mem_hdr_t old = *hdr;
+
+    // Grow/shrink in place (same region) first
+    tux_mem_hdr_t *resized = heap_caps_realloc(hdr, sizeof(tux_mem_hdr_t) + size,
+                                               old.psram ? CAPS_PSRAM : CAPS_INTERNAL);
+    if (resized != NULL) {
+        account(&old, false);
+        resized->size = size;
+        account(resized, true);
+        return resized + 1;
+    }
+
+    // Region is full - move the block
+    void *moved = tux_mem_alloc(size);
+    if (moved == NULL) return NULL;     // old block is still valid
+    memcpy(moved, ptr, old.size < size ? old.size : size);
+    tux_mem_free(ptr);
+    return moved;
+}
+
+static uint8_t heap_frag(uint32_t caps, size_t *free_bytes)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    *free_bytes = info.total_free_bytes;
+    if (info.total_free_bytes == 0) return 0;
+    return 100 - (uint8_t)((uint64_t)info.largest_free_block * 100 / info.total_free_bytes);
+}
+
+void tux_mem_get_stats(tux_mem_stats_t *out)
+{
+    *out = stats;
+    out->frag_internal = heap_frag(CAPS_INTERNAL, &out->free_internal);
+    out->frag_psram = heap_frag(CAPS_PSRAM, &out->free_psram);
+}
+
+const char *tux_mem_class_name(int size_class)
+{
+    static const char *names[TUX_MEM_CLASSES] = {
+        "<=16", "<=32", "<=64", "<=128", "<=256", "<=512", "<=1K", ">1K"
+    };
+    return (size_class >= 0 && size_class < TUX_MEM_CLASSES) ? names[size_class] : "?";
+}
@@ -0,0 +1,76 @@
+/*
+MIT License
+
+Copyright (c) 2022 Sukesh Ashok Kumar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/*
+    LVGL allocator on top of heap_caps (LV_MEM_CUSTOM, see lv_conf.h)
+    Small allocations - styles, object structs, label text - stay in internal
+    RAM where they are touched every frame, larger ones (image/font caches,
+    big widget data) go to PSRAM. ESP-IDF 5 heaps are TLSF so fragmentation
+    behaviour is the same as LVGL's own pool, without the fixed 48KB limit.
+    Enable with idf.py menuconfig => Performance Config => TUX_LV_MEM_CUSTOM
+*/
+
+#ifndef TUX_MEM_H_
+#define TUX_MEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Allocation size classes: <=16, <=32 ... <=1024, >1024 bytes
+#define TUX_MEM_CLASSES 8
+
+typedef struct {
+    size_t used;                // Bytes currently allocated by LVGL
+    size_t peak;                // High-water mark of used
+    size_t used_internal;
+    size_t used_psram;
+    uint32_t live;              // Allocations not freed yet
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failed;
+    uint32_t fallbacks;         // Preferred region was full, used the other one
+    uint32_t by_class[TUX_MEM_CLASSES];     // Allocation count by size class
+    size_t free_internal;       // Free bytes in the heaps we allocate from
+    size_t free_psram;
+    uint8_t frag_internal;      // 100 - largest free block * 100 / free bytes
+    uint8_t frag_psram;
+} tux_mem_stats_t;
+
+void *tux_mem_alloc(size_t size);
+void tux_mem_free(void *ptr);
+void *tux_mem_realloc(void *ptr, size_t size);
+
+void tux_mem_get_stats(tux_mem_stats_t *stats);
+const char *tux_mem_class_name(int size_class);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TUX_MEM_H_
@@ -0,0 +1,135 @@
+# Stand-in for the OpenWeatherMap API - weather, forecast and group endpoints
+# Enable "Fetch weather from the local server" in menuconfig (Weather Config)
+# and point the local URL/port at the machine running this.
+#
+#   python3 mock_weather_server.py [--host 0.0.0.0] [--port 8000] [--fail-every N]
+#
+# Values drift slowly with time so the device sees real changes, timestamps
+# are relative to now so forecast series roll forward like the real thing.
+# Answers carry an ETag and honour If-None-Match with 304 Not Modified.
+import argparse
+import json
+import math
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse, parse_qs
+
+ICONS = ["01d", "02d", "03d", "04d", "09d", "10d", "11d", "13d", "50d"]
+cities = {}         # id -> name, learned from weather/forecast requests
+requests = 0
+
+
+def city_id(name):
+    return zlib.crc32(name.lower().encode()) % 9000000 + 1000000
+
+
+def city_name(qs):
+    if "q" in qs:
+        name = qs["q"][0]
+        cities[city_id(name)] = name
+        return name
+    cid = int(qs.get("id", ["0"])[0].split(",")[0])
+    return cities.get(cid, "City %d" % cid)
+
+
+def temp_at(cid, t):
+    # Daily swing plus a slow per-city drift, 0.1 degree steps
+    base = 15 + (cid % 15)
+    return round(base + 6 * math.sin((t % 86400) / 86400 * 2 * math.pi) + 2 * math.sin(t / 7200 + cid), 1)
+
+
+def icon_at(cid, t):
+    return ICONS[(cid + int(t // 10800)) % len(ICONS)].replace("d", "d" if 6 <= (t // 3600) % 24 < 18 else "n")
+
+
+def current(name, now):
+    cid = city_id(name)
+    step = now - now % 600      # OWM updates about every 10 minutes
+    t = temp_at(cid, step)
+    return {
+        "coord": {"lon": (cid % 360) - 180.0, "lat": (cid % 180) - 90.0},
+        "weather": [{"id": 800, "main": "Clouds", "description": "mock clouds", "icon": icon_at(cid, step)}],
+        "base": "stations",
+        "main": {"temp": t, "feels_like": round(t - 0.4, 1), "temp_min": round(t - 1.5, 1),
+                 "temp_max": round(t + 1.5, 1), "pressure": 1012 + cid % 10, "humidity": 40 + cid % 50,
+                 "sea_level": 1012, "grnd_level": 912},
+        "visibility": 10000,
+        "wind": {"speed": 1.5, "deg": cid % 360},
+        "dt": int(step),
+        "timezone": 19800,
+        "id": cid,
+        "name": name.split(",")[0],
+        "cod": 200,
+    }
+
+
+def forecast(name, now, cnt):
+    cid = city_id(name)
+    start = now - now % 10800 + 10800
+    items = []
+    for i in range(cnt):
+        t = start + i * 10800
+        temp = temp_at(cid, t)
+        items.append({
+            "dt": int(t),
+            "main": {"temp": temp, "feels_like": temp, "temp_min": round(temp - 1, 1),
+                     "temp_max": round(temp + 1, 1), "pressure": 1012, "humidity": 40 + (cid + i) % 50},
+            "weather": [{"id": 800, "main": "Clouds", "description": "mock clouds", "icon": icon_at(cid, t)}],
+            "pop": round(((cid + i) % 10) / 10, 1),
+            "dt_txt": time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime(t)),
+        })
+    return {"cod": "200", "message": 0, "cnt": cnt, "list": items,
+            "city": {"id": cid, "name": name.split(",")[0], "timezone": 19800}}
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"   # keep-alive, like the real API
+
+    def do_GET(self):
+        global requests
+        requests += 1
+        url = urlparse(self.path)
+        qs = parse_qs(url.query)
+        now = time.time()
+
+        if args.fail_every and requests % args.fail_every == 0:
+            return self.reply(429, {"cod": 429, "message": "mock rate limit"})
+
+        if url.path == "/data/2.5/weather":
+            return self.reply(200, current(city_name(qs), now))
+        if url.path == "/data/2.5/forecast":
+            return self.reply(200, forecast(city_name(qs), now, int(qs.get("cnt", ["40"])[0])))
+        if url.path == "/data/2.5/group":
+            ids = [int(i) for i in qs.get("id", [""])[0].split(",") if i]
+            items = [current(cities.get(i, "City %d" % i), now) for i in ids]
+            return self.reply(200, {"cnt": len(items), "list": items})
+        self.reply(404, {"cod": 404, "message": "not found"})
+
+    def reply(self, status, obj):
+        body = json.dumps(obj).encode()
+        etag = '"%08x"' % zlib.crc32(body)
+        if status == 200 and self.headers.get("If-None-Match") == etag:
+            self.send_response(304)
+            self.send_header("ETag", etag)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        if status == 200:
+            self.send_header("ETag", etag)
+        self.end_headers()
+        self.wfile.write(body)
+
+
+parser = argparse.ArgumentParser()
+parser.add_argument("--host", default="0.0.0.0")
+parser.add_argument("--port", type=int, default=8000)
+parser.add_argument("--fail-every", type=int, default=0, help="answer every Nth request with 429")
+args = parser.parse_args()
+
+with ThreadingHTTPServer((args.host, args.port), Handler) as httpd:
+    print("Mock weather server listening at => " + args.host + ":" + str(args.port))
+    httpd.serve_forever()
@@ -0,0 +1,187 @@
+# Delta OTA patches - only what changed between two firmware images
+# The device (components/ota/ota_delta.c) rebuilds the new image from the one
+# it is running plus the patch, so an update downloads the patch instead of
+# the whole ESP32-TUX.bin. Serve the patch next to the full image, the device
+# falls back to the full image when the patch was made for another firmware.
+#
+#   python3 ota_delta.py make  old.bin new.bin build/ESP32-TUX.patch
+#   python3 ota_delta.py apply old.bin build/ESP32-TUX.patch out.bin
+#   python3 ota_delta.py test  old.bin new.bin        (make + apply + verify, prints ratio and times)
+#
+# old.bin is the image the devices run now (keep a copy of every release),
+# new.bin is build/ESP32-TUX.bin. webserver.py run from the project folder
+# serves build/ESP32-TUX.patch next to the image (CONFIG_OTA_DELTA_URL).
+#
+# Patch format, little endian:
+#   header  "TUXD", u8 version, 3 reserved,
+#           u32 source size, 32 byte source sha256, u32 target size, 32 byte target sha256
+#   ops     0x01 COPY   u32 source offset, u32 length    - bytes from the running image
+#           0x02 INSERT u32 length, data                - new bytes
+#           0x00 END
+import argparse
+import hashlib
+import struct
+import sys
+import time
+
+MAGIC = b"TUXD"
+VERSION = 1
+HEADER = struct.Struct("<4sB3xI32sI32s")
+OP_END, OP_COPY, OP_INSERT = 0, 1, 2
+
+KEY = 16            # bytes a match has to start with
+STEP = 4            # source is indexed every STEP bytes - any match of KEY + STEP - 1 is found
+MIN_COPY = 24       # shorter matches cost more as a COPY op (9 bytes) than they save
+
+
+def index_source(src):
+    index = {}
+    for off in range(0, len(src) - KEY + 1, STEP):
+        index.setdefault(src[off:off + KEY], off)
+    return index
+
+
+def make_ops(src, dst):
+    """Greedy matching - yields ("copy", offset, length) / ("insert", bytes)"""
+    index = index_source(src)
+    pos = 0
+    literal_start = 0
+    n = len(dst)
+    while pos + KEY <= n:
+        off = index.get(dst[pos:pos + KEY])
+        if off is None:
+            pos += 1
+            continue
+        # Extend forward, then backward into the pending literal bytes
+        length = KEY
+        while pos + length < n and off + length < len(src) and dst[pos + length] == src[off + length]:
+            length += 1
+        back = 0
+        while pos - back > literal_start and off - back > 0 and dst[pos - back - 1] == src[off - back - 1]:
+            back += 1
+        if length + back < MIN_COPY:
+            pos += 1
+            continue
+        if pos - back > literal_start:
+            yield ("insert", dst[literal_start:pos - back])
+        yield ("copy", off - back, length + back)
+        pos += length
+        literal_start = pos
+    if literal_start < n:
+        yield ("insert", dst[literal_start:])
+
+
+def make_patch(src, dst):
+    out = bytearray(HEADER.pack(MAGIC, VERSION, len(src), hashlib.sha256(src).digest(),
+                                len(dst), hashlib.sha256(dst).digest()))
+    for op in make_ops(src, dst):
+        if op[0] == "copy":
+            out += struct.pack("<BII", OP_COPY, op[1], op[2])
+        else:
+            out += struct.pack("<BI", OP_INSERT, len(op[1])) + op[1]
+    out += bytes([OP_END])
+    return bytes(out)
+
+
+def apply_patch(src, patch):
+    magic, version, src_size, src_sha, dst_size, dst_sha = HEADER.unpack_from(patch, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a TUXD v%d patch" % VERSION)
+    if src_size != len(src) or hashlib.sha256(src).digest() != src_sha:
+        raise ValueError("patch was made for another source image")
+    out = bytearray()
+    pos = HEADER.size
+    while True:
+        op = patch[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_COPY:
+            off, length = struct.unpack_from("<II", patch, pos)
+            pos += 8
+            if off + length > len(src):
+                raise ValueError("COPY outside the source image")
+            out += src[off:off + length]
+        elif op == OP_INSERT:
+            (length,) = struct.unpack_from("<I", patch, pos)
+            pos += 4
+            out += patch[pos:pos + length]
+            pos += length
+        else:
+            raise ValueError("bad op 0x%02x at %d" % (op, pos - 1))
+    if len(out) != dst_size or hashlib.sha256(out).digest() != dst_sha:
+        raise ValueError("result does not match the target sha256")
+    return bytes(out)
+
+
+def stats(patch):
+    copies = inserts = copied = inserted = 0
+    pos = HEADER.size
+    while patch[pos] != OP_END:
+        if patch[pos] == OP_COPY:
+            copies += 1
+            copied += struct.unpack_from("<I", patch, pos + 5)[0]
+            pos += 9
+        else:
+            inserts += 1
+            length = struct.unpack_from("<I", patch, pos + 1)[0]
+            inserted += length
+            pos += 5 + length
+    return copies, copied, inserts, inserted
+
+
+def read(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Delta OTA patches for ESP32-TUX")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("make", help="patch from old to new image")
+    p.add_argument("old")
+    p.add_argument("new")
+    p.add_argument("patch")
+    p = sub.add_parser("apply", help="rebuild the new image like the device does")
+    p.add_argument("old")
+    p.add_argument("patch")
+    p.add_argument("out")
+    p = sub.add_parser("test", help="make and apply, verify and print size ratio and times")
+    p.add_argument("old")
+    p.add_argument("new")
+    args = parser.parse_args()
+
+    if args.cmd == "make":
+        src, dst = read(args.old), read(args.new)
+        patch = make_patch(src, dst)
+        with open(args.patch, "wb") as f:
+            f.write(patch)
+        copies, copied, inserts, inserted = stats(patch)
+        print("%s: %d bytes, %.1f%% of %d (%d copies / %d bytes, %d inserts / %d bytes)" % (
+            args.patch, len(patch), 100.0 * len(patch) / max(len(dst), 1), len(dst), copies, copied, inserts, inserted))
+    elif args.cmd == "apply":
+        try:
+            out = apply_patch(read(args.old), read(args.patch))
+        except ValueError as e:
+            sys.exit("apply failed: %s" % e)
+        with open(args.out, "wb") as f:
+            f.write(out)
+        print("%s: %d bytes, sha256 ok" % (args.out, len(out)))
+    else:
+        src, dst = read(args.old), read(args.new)
+        start = time.time()
+        patch = make_patch(src, dst)
+        made = time.time() - start
+        start = time.time()
+        out = apply_patch(src, patch)
+        applied = time.time() - start
+        if out != dst:
+            sys.exit("FAIL: applied image differs from %s" % args.new)
+        copies, copied, inserts, inserted = stats(patch)
+        print("patch %d bytes = %.1f%% of the %d byte image (%d copies, %d inserts / %d bytes)" % (
+            len(patch), 100.0 * len(patch) / max(len(dst), 1), len(dst), copies, inserts, inserted))
+        print("make %.2fs, apply %.3fs - OK" % (made, applied))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,234 @@
+# Firmware size report - per component and per symbol, checked against budgets
+# Reads the linker map the build writes next to the ELF (build/ESP32-TUX.map),
+# plain Python, no IDF or toolchain needed. Run by the size-budget build target
+# (idf.py size-budget, part of every build with CONFIG_TUX_SIZE_BUDGET_CHECK).
+#
+#   python3 size_report.py build/ESP32-TUX.map [--budgets size_budgets.json]
+#       [--partitions partitions/partition-8MB.csv] [--symbols 30]
+#       [--component lvgl] [--json out.json] [--update-budgets]
+#
+# Memory types:
+#   flash  what the component adds to the app image (code, rodata, and the
+#          initial values of IRAM code and DRAM data that are copied at boot)
+#   iram   instruction RAM (.iram0.*)
+#   dram   internal data RAM (.dram0.data/.bss, .noinit)
+#
+# Exits with 1 when a component is over its budget or the image does not fit
+# the smallest app partition. --update-budgets writes the current sizes plus
+# "headroom_percent" back into the budget file after a known good build.
+import argparse
+import json
+import os
+import re
+import sys
+from collections import defaultdict
+
+MEM_TYPES = ("flash", "iram", "dram")
+
+# Output section -> (memory type or None, part of the app image)
+SECTIONS = [
+    (re.compile(r"^\.flash\.rodata_noload"), None, False),
+    (re.compile(r"^\.flash\.(text|rodata|appdesc|tdata)"), None, True),
+    (re.compile(r"^\.eh_frame"), None, True),
+    (re.compile(r"^\.iram0\.bss"), "iram", False),
+    (re.compile(r"^\.iram0\."), "iram", True),
+    (re.compile(r"^\.dram0\.bss|^\.noinit"), "dram", False),
+    (re.compile(r"^\.dram0\."), "dram", True),
+    (re.compile(r"^\.rtc"), None, True),
+]
+
+RE_OUTPUT = re.compile(r"^(\.[\w.]+)(?:\s+0x[0-9a-f]+\s+0x[0-9a-f]+)?\s*$")
+RE_INPUT = re.compile(r"^ ([.\w$-]+|COMMON)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*))?$")
+RE_INPUT_CONT = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+RE_ARCHIVE = re.compile(r"(?:^|/)lib([^/()]+)\.a\(([^)]+)\)$")
+RE_ANON = re.compile(r"^(str1\.\d+|cst\d+|\d+|)$")     # string pools, numbered sections
+SYMBOL_PREFIX = re.compile(r"^\.(literal|text|rodata|data|bss|sbss|sdata|iram1|dram1|noinit|tbss|tdata)"
+                           r"(\.str1\.\d+|\.cst\d+)?\.")
+
+
+def classify(section):
+    for pattern, mem, in_image in SECTIONS:
+        if pattern.match(section):
+            return mem, in_image
+    return None, False
+
+
+def component_of(path):
+    m = RE_ARCHIVE.search(path)
+    if m:
+        return m.group(1)
+    return os.path.basename(path)      # linker generated or loose object
+
+
+def symbol_of(section, obj):
+    name = SYMBOL_PREFIX.sub("", section, count=1)
+    if name == section or RE_ANON.match(name):
+        return "(%s %s)" % (section, obj)   # no -ffunction-sections name, keep where it came from
+    return name
+
+
+def parse_map(path):
+    """Yields (output section, input section, size, archive member path)"""
+    out_section = None
+    pending = None
+    in_map = False
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not in_map:
+                in_map = line.startswith("Linker script and memory map")
+                continue
+            if pending:
+                m = RE_INPUT_CONT.match(line)
+                if m:
+                    yield out_section, pending, int(m.group(2), 16), m.group(3).strip()
+                pending = None
+                continue
+            m = RE_OUTPUT.match(line)
+            if m:
+                out_section = m.group(1)
+                continue
+            if out_section is None:
+                continue
+            m = RE_INPUT.match(line)
+            if m:
+                if m.group(2) is None:
+                    pending = m.group(1)        # long name, address and size on the next line
+                else:
+                    yield out_section, m.group(1), int(m.group(3), 16), m.group(4).strip()
+
+
+def collect(map_path):
+    components = defaultdict(lambda: {t: 0 for t in MEM_TYPES})
+    symbols = defaultdict(int)          # (component, symbol, memory type) -> bytes
+    totals = {t: 0 for t in MEM_TYPES}
+    for out_section, in_section, size, obj in parse_map(map_path):
+        if size == 0:
+            continue
+        mem, in_image = classify(out_section)
+        if mem is None and not in_image:
+            continue                    # PSRAM .ext_ram.bss, debug info, ...
+        comp = component_of(obj)
+        if in_image:
+            components[comp]["flash"] += size
+            totals["flash"] += size
+        if mem:
+            components[comp][mem] += size
+            totals[mem] += size
+        kind = mem if mem else "flash"
+        symbols[(comp, symbol_of(in_section, os.path.basename(obj)), kind)] += size
+    return components, symbols, totals
+
+
+def app_slot_size(csv_path):
+    """Smallest app partition in a partition table CSV - every OTA slot has to hold the image"""
+    units = {"K": 1024, "M": 1024 * 1024}
+    sizes = []
+    with open(csv_path) as f:
+        for line in f:
+            line = line.split("#")[0].strip()
+            cols = [c.strip() for c in line.split(",")]
+            if len(cols) < 5 or cols[1] != "app":
+                continue
+            size = cols[4]
+            if size[-1:].upper() in units:
+                sizes.append(int(size[:-1], 0) * units[size[-1].upper()])
+            else:
+                sizes.append(int(size, 0))
+    return min(sizes) if sizes else None
+
+
+def kb(n):
+    return "%8.1f" % (n / 1024.0)
+
+
+def report(components, symbols, totals, args):
+    print("%-28s %9s %9s %9s" % ("Component (KB)", "flash", "iram", "dram"))
+    for comp, sizes in sorted(components.items(), key=lambda c: -c[1]["flash"]):
+        print("%-28s %s  %s  %s" % (comp[:28], kb(sizes["flash"]), kb(sizes["iram"]), kb(sizes["dram"])))
+    print("%-28s %s  %s  %s" % ("Total", kb(totals["flash"]), kb(totals["iram"]), kb(totals["dram"])))
+
+    rows = [(size, comp, sym, mem) for (comp, sym, mem), size in symbols.items()
+            if args.component is None or comp == args.component]
+    rows.sort(reverse=True)
+    if args.symbols and rows:
+        print("\nLargest symbols%s" % (" in " + args.component if args.component else ""))
+        for size, comp, sym, mem in rows[:args.symbols]:
+            print("%9d  %-5s %-16s %s" % (size, mem, comp[:16], sym))
+
+
+def check(components, totals, budgets, slot):
+    failed = []
+    for comp, limits in sorted(budgets.get("components", {}).items()):
+        for mem, limit in limits.items():
+            size = components.get(comp, {}).get(mem, 0)
+            if size > limit:
+                failed.append("%s %s: %d bytes, budget %d (+%d)" % (comp, mem, size, limit, size - limit))
+    for mem, limit in budgets.get("total", {}).items():
+        if totals[mem] > limit:
+            failed.append("total %s: %d bytes, budget %d (+%d)" % (mem, totals[mem], limit, totals[mem] - limit))
+    if slot:
+        used = 100.0 * totals["flash"] / slot
+        print("\nApp image ~%d bytes, %.1f%% of the %dKB app partition" % (totals["flash"], used, slot // 1024))
+        if totals["flash"] > slot:
+            failed.append("app image %d bytes does not fit the %d byte app partition" % (totals["flash"], slot))
+        elif used > budgets.get("partition_warn_percent", 90):
+            print("warning: app partition more than %d%% full" % budgets.get("partition_warn_percent", 90))
+    return failed
+
+
+def update_budgets(path, budgets, components, totals):
+    headroom = 1 + budgets.get("headroom_percent", 5) / 100.0
+    budgets["components"] = {
+        comp: {mem: int(size * headroom) for mem, size in sizes.items() if size}
+        for comp, sizes in sorted(components.items()) if sizes["flash"] >= budgets.get("min_bytes", 1024)
+    }
+    budgets["total"] = {mem: int(size * headroom) for mem, size in totals.items()}
+    with open(path, "w") as f:
+        json.dump(budgets, f, indent=4, sort_keys=True)
+        f.write("\n")
+    print("\nBudgets written to %s (%d components)" % (path, len(budgets["components"])))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Firmware size report and budget check")
+    parser.add_argument("map", help="linker map file, build/<project>.map")
+    parser.add_argument("--budgets", help="budget file (JSON)")
+    parser.add_argument("--partitions", help="partition table CSV, image must fit its smallest app slot")
+    parser.add_argument("--symbols", type=int, default=30, help="largest N symbols to list (0 for none)")
+    parser.add_argument("--component", help="list the largest symbols of this component only")
+    parser.add_argument("--json", help="write the per component sizes here")
+    parser.add_argument("--update-budgets", action="store_true", help="store current sizes + headroom as budgets")
+    args = parser.parse_args()
+
+    components, symbols, totals = collect(args.map)
+    if not components:
+        sys.exit("No sections found in %s - not a GNU ld map file?" % args.map)
+    report(components, symbols, totals, args)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"components": components, "total": totals}, f, indent=4, sort_keys=True)
+
+    budgets = {}
+    if args.budgets and os.path.exists(args.budgets):
+        with open(args.budgets) as f:
+            budgets = json.load(f)
+    if args.update_budgets:
+        if not args.budgets:
+            sys.exit("--update-budgets needs --budgets")
+        update_budgets(args.budgets, budgets, components, totals)
+        return
+
+    slot = app_slot_size(args.partitions) if args.partitions else None
+    failed = check(components, totals, budgets, slot)
+    if failed:
+        print("\nSIZE BUDGET EXCEEDED")
+        for line in failed:
+            print("  " + line)
+        sys.exit(1)
+    print("\nSize budgets OK")
+
+
+if __name__ == "__main__":
+    main()
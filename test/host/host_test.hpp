@@ -0,0 +1,27 @@
+/*
+    Minimal test helpers for the host build - no framework needed.
+    CHECK() logs and counts failures, TEST_RESULT() is the exit code.
+*/
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+static int test_failures = 0;
+static int test_checks = 0;
+
+#define CHECK(cond) do { \
+        test_checks++; \
+        if (!(cond)) { test_failures++; printf("FAIL %s:%d  %s\n", __FILE__, __LINE__, #cond); } \
+    } while (0)
+
+#define CHECK_STR(a, b) CHECK(strcmp((a), (b)) == 0)
+
+#define TEST_RESULT() (printf("%d checks, %d failed\n", test_checks, test_failures), test_failures ? 1 : 0)
+
+// Wall clock in microseconds for the benchmark parts
+static inline double test_now_us()
+{
+    using namespace std::chrono;
+    return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
@@ -4,12 +4,51 @@
 # Output when client connects:
 # Web Server at => 192.168.1.100:443
 # 192.168.1.22 - - [12/Feb/2022 02:32:56] "GET /default.html HTTP/1.1" 200 -
+#
+# Run from the project folder, the device asks for (OTA Config in menuconfig)
+#   /build/ESP32-TUX.patch    delta from ota_delta.py, 404 when there is none
+#   /build/ESP32-TUX.bin.zz   zlib compressed image, made here from the .bin if not on disk
+#   /build/ESP32-TUX.bin      plain image
 import http.server
+import os
 import ssl
+import time
+import zlib
 
 HOST = '192.168.1.128'
 PORT = 443
-Handler = http.server.SimpleHTTPRequestHandler 
+
+compressed = {}     # path -> (mtime of the .bin, compressed bytes)
+
+
+class Handler(http.server.SimpleHTTPRequestHandler):
+    def do_GET(self):
+        path = self.translate_path(self.path)
+        if path.endswith(".zz") and not os.path.exists(path) and os.path.isfile(path[:-3]):
+            return self.send_compressed(path[:-3])
+        start = time.time()
+        super().do_GET()
+        if os.path.isfile(path):
+            self.log_message("sent %s in %.1fs", self.path, time.time() - start)
+
+    def send_compressed(self, source):
+        mtime = os.path.getmtime(source)
+        if compressed.get(source, (None,))[0] != mtime:
+            with open(source, "rb") as f:
+                data = f.read()
+            compressed[source] = (mtime, zlib.compress(data, 9))
+            self.log_message("compressed %s %d -> %d bytes (%.1f%%)", source, len(data),
+                             len(compressed[source][1]), 100.0 * len(compressed[source][1]) / max(len(data), 1))
+        body = compressed[source][1]
+        start = time.time()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/zlib")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+        self.log_message("sent %s (%d bytes) in %.1fs", self.path, len(body), time.time() - start)
+
+
 with http.server.HTTPServer((HOST, PORT), Handler) as httpd:
     print("Web Server listening at => " + HOST + ":" + str(PORT))
     sslcontext = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)